@@ -0,0 +1,267 @@
+#include <assert.h>
+#include <exception>
+
+#include "async_link.h"
+
+using namespace std;
+
+// Async_task -------------------------------------------------------------
+
+Async_task::promise_type::promise_type()
+{
+	scheduler = NULL;
+}
+
+Async_task::promise_type::~promise_type()
+{
+	if (scheduler != NULL) {
+		scheduler->finish();
+	}
+}
+
+Async_task Async_task::promise_type::get_return_object()
+{
+	return Async_task(
+	 std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+std::suspend_always Async_task::promise_type::initial_suspend() noexcept
+{
+	return std::suspend_always();
+}
+
+std::suspend_never Async_task::promise_type::final_suspend() noexcept
+{
+	return std::suspend_never();
+}
+
+void Async_task::promise_type::return_void()
+{
+}
+
+void Async_task::promise_type::unhandled_exception()
+{
+	std::terminate();
+}
+
+Async_task::Async_task(std::coroutine_handle<promise_type> handle0)
+{
+	handle = handle0;
+}
+
+Async_task::Async_task(Async_task&& task)
+{
+	handle = task.handle;
+	task.handle = NULL;
+}
+
+Async_task::~Async_task()
+{
+	if (handle) {
+		handle.destroy();
+	}
+}
+
+// Async_scheduler --------------------------------------------------------
+
+Async_scheduler::Async_scheduler(unsigned int threads)
+ : pool(threads)
+{
+	pthread_mutex_init(&mutex,NULL);
+	pthread_cond_init(&done,NULL);
+	live = 0;
+}
+
+Async_scheduler::~Async_scheduler()
+{
+	wait();
+	// a task's last act was finish; let the pool see its run through
+	pool.wait();
+	pthread_cond_destroy(&done);
+	pthread_mutex_destroy(&mutex);
+}
+
+void Async_scheduler::spawn(Async_task&& task)
+{
+	pthread_mutex_lock(&mutex);
+	live++;
+	pthread_mutex_unlock(&mutex);
+
+	void* address = task.handle.address();
+	task.handle.promise().scheduler = this;
+	task.handle = NULL; // the task frees itself now
+	post(address);
+}
+
+void Async_scheduler::wait()
+{
+	pthread_mutex_lock(&mutex);
+	while (live > 0) {
+		pthread_cond_wait(&done,&mutex);
+	}
+	pthread_mutex_unlock(&mutex);
+}
+
+unsigned int Async_scheduler::get_threads() const
+{
+	return pool.get_threads();
+}
+
+unsigned long Async_scheduler::get_resumes() const
+{
+	return pool.get_tasks_run();
+}
+
+// Thread_pool task: run a task until it next suspends or finishes
+void Async_scheduler::resume(void* task)
+{
+	std::coroutine_handle<>::from_address(task).resume();
+}
+
+void Async_scheduler::post(void* task)
+{
+	pool.submit(&Async_scheduler::resume,task);
+}
+
+// from a finishing task's promise, on a pool thread
+void Async_scheduler::finish()
+{
+	pthread_mutex_lock(&mutex);
+	if (--live == 0) {
+		pthread_cond_broadcast(&done);
+	}
+	pthread_mutex_unlock(&mutex);
+}
+
+// Async_link -------------------------------------------------------------
+
+Async_link::Async_link(Link_layer* link0,Async_scheduler* scheduler0)
+{
+	link = link0;
+	scheduler = scheduler0;
+	sender.store(NULL);
+	receiver.store(NULL);
+	link->set_listener(&Async_link::listener,this);
+}
+
+Async_link::~Async_link()
+{
+	// set_listener takes the link's lock: no listener runs past here
+	link->set_listener(NULL,NULL);
+	// with the listener gone, a task still waiting would never resume,
+	// and the scheduler would wait for it forever
+	assert(sender.load() == NULL);
+	assert(receiver.load() == NULL);
+}
+
+Link_layer* Async_link::get_link()
+{
+	return link;
+}
+
+Async_link::Send Async_link::async_send(unsigned char buffer[],
+ unsigned int length)
+{
+	Send send;
+	send.async_link = this;
+	send.buffer = buffer;
+	send.length = length;
+	send.sent = 0;
+	return send;
+}
+
+Async_link::Receive Async_link::async_receive(unsigned char buffer[])
+{
+	Receive receive;
+	receive.async_link = this;
+	receive.buffer = buffer;
+	receive.received = 0;
+	return receive;
+}
+
+// store task in waiter, then look at the link again: if it became ready
+// meanwhile and the listener has not taken task, take it back and go on
+// at once. Past the store task may already be running elsewhere, so this
+// touches only the link and waiter
+bool Async_link::park(std::atomic<void*>& waiter,
+ std::coroutine_handle<> task,bool (Link_layer::*ready)())
+{
+	void* address = task.address();
+	waiter.store(address);
+	// pairs with the fence in listener: either we see the ring change,
+	// or the listener sees us waiting
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if ((link->*ready)() && waiter.exchange(NULL) == address) {
+		return false;
+	}
+	return true;
+}
+
+// Link_layer listener, on the protocol loop with the link's lock held:
+// the loop delivered frames or freed send ring slots. Hands a waiting
+// task to the pool only if its link is ready for it, so that as the only
+// sender, or receiver, it is sure to succeed when it resumes
+void Async_link::listener(void* async_link0)
+{
+	Async_link* async_link = (Async_link*) async_link0;
+	Link_layer* link = async_link->link;
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (async_link->sender.load(std::memory_order_acquire) != NULL
+	 && link->can_send()) {
+		void* task = async_link->sender.exchange(NULL);
+		if (task != NULL) {
+			async_link->scheduler->post(task);
+		}
+	}
+	if (async_link->receiver.load(std::memory_order_acquire) != NULL
+	 && link->can_receive()) {
+		void* task = async_link->receiver.exchange(NULL);
+		if (task != NULL) {
+			async_link->scheduler->post(task);
+		}
+	}
+}
+
+// Async_link::Send -------------------------------------------------------
+
+bool Async_link::Send::await_ready()
+{
+	sent = async_link->link->send(buffer,length);
+	return sent > 0;
+}
+
+bool Async_link::Send::await_suspend(std::coroutine_handle<> task)
+{
+	return async_link->park(async_link->sender,task,&Link_layer::can_send);
+}
+
+unsigned int Async_link::Send::await_resume()
+{
+	if (sent == 0) {
+		sent = async_link->link->send(buffer,length);
+	}
+	return sent;
+}
+
+// Async_link::Receive ----------------------------------------------------
+
+bool Async_link::Receive::await_ready()
+{
+	received = async_link->link->receive(buffer);
+	return received > 0;
+}
+
+bool Async_link::Receive::await_suspend(std::coroutine_handle<> task)
+{
+	return async_link->park(async_link->receiver,task,
+	 &Link_layer::can_receive);
+}
+
+unsigned int Async_link::Receive::await_resume()
+{
+	if (received == 0) {
+		received = async_link->link->receive(buffer);
+	}
+	return received;
+}
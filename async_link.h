@@ -0,0 +1,161 @@
+#include <atomic>
+#include <coroutine>
+#include <pthread.h>
+
+#include "link_layer.h"
+#include "thread_pool.h"
+
+#ifndef ASYNC_LINK_H
+#define ASYNC_LINK_H
+
+// C++20: compile this header's users with -std=c++20
+
+using namespace std;
+
+class Async_scheduler;
+
+// Async_task -------------------------------------------------------------
+
+// Return type of an application coroutine, such as one flow's sends or
+// receives. It does not start until given to Async_scheduler::spawn,
+// and frees itself when it returns
+class Async_task {
+public:
+	struct promise_type {
+		Async_scheduler* scheduler; // set by spawn
+
+		promise_type();
+		~promise_type(); // tells scheduler the task is done
+
+		Async_task get_return_object();
+		std::suspend_always initial_suspend() noexcept;
+		std::suspend_never final_suspend() noexcept;
+		void return_void();
+		void unhandled_exception(); // tasks do not throw: terminates
+	};
+
+	Async_task(Async_task&& task);
+	// frees a task never spawned
+	~Async_task();
+private:
+	friend class Async_scheduler;
+
+	Async_task(std::coroutine_handle<promise_type> handle);
+	Async_task(const Async_task&);
+	Async_task& operator=(const Async_task&);
+
+	std::coroutine_handle<promise_type> handle;
+};
+
+// Async_scheduler --------------------------------------------------------
+
+// Runs Async_tasks on a Thread_pool. A task runs on a pool thread until it
+// awaits a link that is not ready, then gives the thread up; the link's
+// protocol loop hands it back to the pool once it is. Thousands of tasks
+// can so share a few threads, none of them spinning
+class Async_scheduler {
+public:
+	// threads 0 starts one thread per online processor. throw
+	// Thread_pool_exception if a thread cannot be started
+	Async_scheduler(unsigned int threads = 0);
+	// waits for every task
+	~Async_scheduler();
+
+	// run task on one of the threads; any thread may call it
+	void spawn(Async_task&& task);
+
+	// return once every task spawned so far has finished; called from
+	// outside the pool
+	void wait();
+
+	unsigned int get_threads() const;
+	// times a task was started or resumed
+	unsigned long get_resumes() const;
+private:
+	friend class Async_task;
+	friend class Async_link;
+
+	Async_scheduler(const Async_scheduler&);
+	Async_scheduler& operator=(const Async_scheduler&);
+
+	static void resume(void* task);
+	void post(void* task); // resume the task at this address on the pool
+	void finish();
+
+	Thread_pool pool;
+
+	// tasks spawned and not yet finished; wait sleeps on done
+	pthread_mutex_t mutex;
+	pthread_cond_t done;
+	unsigned long live; // guarded by mutex
+};
+
+// Async_link -------------------------------------------------------------
+
+// Awaitable send and receive on a real-time Link_layer, for tasks of one
+// Async_scheduler:
+//
+//	unsigned int n = co_await async_link.async_send(buffer,length);
+//	unsigned int m = co_await async_link.async_receive(buffer);
+//
+// As with send and receive, one task at a time sends and one receives
+class Async_link {
+public:
+	// takes over link's listener until destroyed. link runs on a thread
+	// of its own or on a Reactor, not on a Simulator
+	Async_link(Link_layer* link,Async_scheduler* scheduler);
+	// no task may still be suspended in async_send or async_receive
+	~Async_link();
+
+	// co_await: send, suspending while the send ring is full; returns
+	// length. throw Link_layer_exception as send does
+	class Send {
+	public:
+		bool await_ready();
+		bool await_suspend(std::coroutine_handle<> task);
+		unsigned int await_resume();
+	private:
+		friend class Async_link;
+		Async_link* async_link;
+		unsigned char* buffer;
+		unsigned int length;
+		unsigned int sent;
+	};
+	Send async_send(unsigned char buffer[],unsigned int length);
+
+	// co_await: receive, suspending until a frame is delivered; returns
+	// its length
+	class Receive {
+	public:
+		bool await_ready();
+		bool await_suspend(std::coroutine_handle<> task);
+		unsigned int await_resume();
+	private:
+		friend class Async_link;
+		Async_link* async_link;
+		unsigned char* buffer;
+		unsigned int received;
+	};
+	Receive async_receive(unsigned char buffer[]);
+
+	Link_layer* get_link();
+private:
+	Async_link(const Async_link&);
+	Async_link& operator=(const Async_link&);
+
+	static void listener(void* async_link);
+	bool park(std::atomic<void*>& waiter,std::coroutine_handle<> task,
+	 bool (Link_layer::*ready)());
+
+	Link_layer* link;
+	Async_scheduler* scheduler;
+
+	// the task suspended in async_send, or async_receive, if any. A task
+	// stores itself and then checks the link once more; the listener
+	// checks the link and then takes the task. Whoever takes it back
+	// resumes it, so exactly one does
+	std::atomic<void*> sender;
+	std::atomic<void*> receiver;
+};
+
+#endif
@@ -0,0 +1,391 @@
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "async_link.h"
+#include "reactor.h"
+#include "timeval_operators.h"
+
+using namespace std;
+
+// Async_link test: every task that parks in async_send or async_receive
+// is resumed exactly once. First, on links driven by a Simulator, so that
+// the listener runs only when the test steps it, a counting coroutine
+// parks by hand: on a link that is not ready it must stay parked until
+// the listener hands it to the pool, then be resumed once; on a link that
+// is ready it must take itself back, and no later listener may resume it.
+// Then, in real time, a sending and a receiving task for each of a few
+// link pairs on a Reactor, the receivers spawned first so that they park
+// on an empty link and the senders park on full send rings. Each co_await
+// goes through a wrapper that counts the awaits that parked and the
+// resumes that followed them: a lost wakeup leaves a task parked and the
+// scheduler waiting past the time limit, and a second resume shows as
+// more resumes than parks, or as frames skipped or repeated.
+
+const unsigned int PAIRS = 8;
+const unsigned int FRAMES = 2000;
+const unsigned int THREADS = 2;
+const unsigned int NUM_SEQ = 64;
+const unsigned int MAX_WIN = 8;
+const unsigned int TIMEOUT = 20000;
+const unsigned int BANDWIDTH = 1000000; // bits per second, simulated
+const unsigned int TIME_LIMIT = 10; // seconds to wait for the tasks
+const unsigned int SETTLE_TIME = 10000; // microseconds for a stray resume
+
+atomic<unsigned long> parked(0);
+atomic<unsigned long> resumed(0);
+atomic<unsigned long> out_of_order(0);
+bool failed = false;
+
+struct timeval now()
+{
+	struct timeval t;
+	gettimeofday(&t,NULL);
+	return t;
+}
+
+// wait up to TIME_LIMIT for count to reach n
+bool wait_for(const atomic<unsigned long>& count,unsigned long n)
+{
+	struct timeval deadline = now()+usec_to_timeval(TIME_LIMIT*1000000ul);
+	while (count.load() < n) {
+		if (deadline < now()) {
+			return false;
+		}
+		sched_yield();
+	}
+	return true;
+}
+
+// hand-parked ------------------------------------------------------------
+
+// a coroutine that counts its resumes, to park in place of a task. It
+// suspends after each, so the scheduler may resume it any number of times
+class Resume_counter {
+public:
+	struct promise_type {
+		Resume_counter get_return_object()
+		{
+			return Resume_counter(std::coroutine_handle<
+			 promise_type>::from_promise(*this));
+		}
+		std::suspend_always initial_suspend() noexcept
+		{
+			return std::suspend_always();
+		}
+		std::suspend_always final_suspend() noexcept
+		{
+			return std::suspend_always();
+		}
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+
+	Resume_counter(std::coroutine_handle<promise_type> handle0)
+	 : handle(handle0) {}
+
+	std::coroutine_handle<promise_type> handle;
+};
+
+Resume_counter count_resumes(atomic<unsigned long>* resumes)
+{
+	while (true) {
+		(*resumes)++;
+		co_await std::suspend_always();
+	}
+}
+
+// run the simulation until the link is ready; false if it runs out first
+bool step_until(Simulator& simulator,Link_layer& link,
+ bool (Link_layer::*ready)())
+{
+	while (!(link.*ready)()) {
+		if (!simulator.step()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// run the simulation to its end, receiving whatever b delivers
+void settle(Simulator& simulator,Link_layer& b)
+{
+	unsigned char buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	do {
+		while (b.receive(buffer) > 0) {
+		}
+	} while (simulator.step());
+	while (b.receive(buffer) > 0) {
+	}
+}
+
+// after the listener has had its chances, resumes must still be n
+void check_resumes(const atomic<unsigned long>& resumes,unsigned long n,
+ const char* what)
+{
+	if (!wait_for(resumes,n)) {
+		cout << "FAIL: " << what << ": never resumed" << endl;
+		exit(1);
+	}
+	usleep(SETTLE_TIME);
+	if (resumes.load() != n) {
+		cout << "FAIL: " << what << ": resumed " << resumes.load()
+		 << " times, not " << n << endl;
+		failed = true;
+	}
+}
+
+void check_hand_parked()
+{
+	Simulator simulator;
+	Impair impair;
+	Physical_layer physical_layer(impair,impair,NULL,NULL,2*MAX_WIN,
+	 BANDWIDTH,&simulator);
+	Link_layer a(physical_layer.get_a_interface(),NUM_SEQ,MAX_WIN,
+	 TIMEOUT);
+	Link_layer b(physical_layer.get_b_interface(),NUM_SEQ,MAX_WIN,
+	 TIMEOUT);
+	Async_scheduler* scheduler = new Async_scheduler(THREADS);
+	Async_link* async_a = new Async_link(&a,scheduler);
+	Async_link* async_b = new Async_link(&b,scheduler);
+	unsigned char buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	memset(buffer,0,sizeof(buffer));
+	const unsigned int length = Link_layer::MAXIMUM_DATA_LENGTH;
+	atomic<unsigned long> resumes[4];
+	Resume_counter* counters[4];
+	for (unsigned int i = 0; i < 4; i++) {
+		resumes[i] = 0;
+		counters[i] = new Resume_counter(count_resumes(&resumes[i]));
+	}
+
+	// a sender parked on a full send ring, handed off by the listener
+	while (a.send(buffer,length) > 0) {
+	}
+	Async_link::Send send = async_a->async_send(buffer,length);
+	if (!send.await_suspend(counters[0]->handle)) {
+		cout << "FAIL: a sender did not park on a full ring" << endl;
+		exit(1);
+	}
+	usleep(SETTLE_TIME);
+	if (resumes[0].load() != 0) {
+		cout << "FAIL: a parked sender resumed before the ring had room"
+		 << endl;
+		failed = true;
+	}
+	if (!step_until(simulator,a,&Link_layer::can_send)) {
+		cout << "FAIL: the send ring never had room" << endl;
+		exit(1);
+	}
+	settle(simulator,b);
+	check_resumes(resumes[0],1,"a parked sender");
+
+	// a receiver parked on an empty link, handed off by the listener
+	Async_link::Receive receive = async_b->async_receive(buffer);
+	if (!receive.await_suspend(counters[1]->handle)) {
+		cout << "FAIL: a receiver did not park on an empty link"
+		 << endl;
+		exit(1);
+	}
+	a.send(buffer,length);
+	if (!step_until(simulator,b,&Link_layer::can_receive)) {
+		cout << "FAIL: the frame was never delivered" << endl;
+		exit(1);
+	}
+	settle(simulator,b);
+	check_resumes(resumes[1],1,"a parked receiver");
+
+	// a sender finding room as it parks takes itself back; the
+	// listener, run by the sends after it, must not resume it too
+	send = async_a->async_send(buffer,length);
+	if (send.await_suspend(counters[2]->handle)) {
+		cout << "FAIL: a sender parked with room in the ring" << endl;
+		exit(1);
+	}
+	a.send(buffer,length);
+	settle(simulator,b);
+	check_resumes(resumes[2],0,"a sender that took itself back");
+
+	// likewise a receiver finding a frame
+	a.send(buffer,length);
+	if (!step_until(simulator,b,&Link_layer::can_receive)) {
+		cout << "FAIL: the frame was never delivered" << endl;
+		exit(1);
+	}
+	receive = async_b->async_receive(buffer);
+	if (receive.await_suspend(counters[3]->handle)) {
+		cout << "FAIL: a receiver parked with a frame waiting" << endl;
+		exit(1);
+	}
+	a.send(buffer,length);
+	settle(simulator,b);
+	check_resumes(resumes[3],0,"a receiver that took itself back");
+
+	delete async_a;
+	delete async_b;
+	// lets the pool finish any resume before the counters go
+	delete scheduler;
+	for (unsigned int i = 0; i < 4; i++) {
+		counters[i]->handle.destroy();
+		delete counters[i];
+	}
+}
+
+// tasks ------------------------------------------------------------------
+
+// co_await as Awaiter does, counting parks and the resumes after them.
+// Once the awaiter has parked the task it may already be running on
+// another thread, so await_suspend then touches only the counters
+template <class Awaiter>
+class Counted {
+public:
+	Counted(Awaiter awaiter0) : awaiter(awaiter0), parking(false) {}
+
+	bool await_ready()
+	{
+		return awaiter.await_ready();
+	}
+
+	bool await_suspend(std::coroutine_handle<> task)
+	{
+		parking = true;
+		if (!awaiter.await_suspend(task)) {
+			parking = false;
+			return false;
+		}
+		parked++;
+		return true;
+	}
+
+	unsigned int await_resume()
+	{
+		if (parking) {
+			resumed++;
+			parking = false;
+		}
+		return awaiter.await_resume();
+	}
+private:
+	Awaiter awaiter;
+	bool parking;
+};
+
+Async_task send_flow(Async_link* link)
+{
+	unsigned char buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	memset(buffer,0,sizeof(buffer));
+	for (unsigned int i = 0; i < FRAMES; i++) {
+		memcpy(buffer,&i,sizeof(i));
+		co_await Counted<Async_link::Send>(link->async_send(buffer,
+		 Link_layer::MAXIMUM_DATA_LENGTH));
+	}
+}
+
+Async_task receive_flow(Async_link* link)
+{
+	unsigned char buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	for (unsigned int i = 0; i < FRAMES; i++) {
+		co_await Counted<Async_link::Receive>(
+		 link->async_receive(buffer));
+		unsigned int k;
+		memcpy(&k,buffer,sizeof(k));
+		if (k != i) {
+			out_of_order++;
+		}
+	}
+}
+
+struct Waiter {
+	Async_scheduler* scheduler;
+	atomic<bool> done;
+};
+
+void* wait_for_tasks(void* waiter0)
+{
+	Waiter* waiter = (Waiter*) waiter0;
+	waiter->scheduler->wait();
+	waiter->done = true;
+	return NULL;
+}
+
+int main(int argc,char* argv[])
+{
+	check_hand_parked();
+
+	Reactor reactor(1);
+	Async_scheduler scheduler(THREADS);
+	Impair impair;
+	Physical_layer* physical_layer[PAIRS];
+	Link_layer* a[PAIRS];
+	Link_layer* b[PAIRS];
+	Async_link* async_a[PAIRS];
+	Async_link* async_b[PAIRS];
+	for (unsigned int i = 0; i < PAIRS; i++) {
+		physical_layer[i] = new Physical_layer(impair,impair,NULL,NULL,
+		 MAX_WIN);
+		a[i] = new Link_layer(physical_layer[i]->get_a_interface(),
+		 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::GO_BACK_N,
+		 Link_layer::DEFAULT_RECEIVE_DEPTH,ONES_COMPLEMENT,&reactor);
+		b[i] = new Link_layer(physical_layer[i]->get_b_interface(),
+		 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::GO_BACK_N,
+		 Link_layer::DEFAULT_RECEIVE_DEPTH,ONES_COMPLEMENT,&reactor);
+		async_a[i] = new Async_link(a[i],&scheduler);
+		async_b[i] = new Async_link(b[i],&scheduler);
+	}
+
+	for (unsigned int i = 0; i < PAIRS; i++) {
+		scheduler.spawn(receive_flow(async_b[i]));
+	}
+	for (unsigned int i = 0; i < PAIRS; i++) {
+		scheduler.spawn(send_flow(async_a[i]));
+	}
+
+	// on a thread of its own, so that a task never resumed fails
+	Waiter waiter;
+	waiter.scheduler = &scheduler;
+	waiter.done = false;
+	pthread_t thread;
+	pthread_create(&thread,NULL,&wait_for_tasks,&waiter);
+	struct timeval deadline = now()+usec_to_timeval(TIME_LIMIT*1000000ul);
+	while (!waiter.done.load()) {
+		if (deadline < now()) {
+			cout << "FAIL: " << parked.load()-resumed.load()
+			 << " parked tasks never resumed" << endl;
+			exit(1);
+		}
+		sched_yield();
+	}
+	pthread_join(thread,NULL);
+
+	if (resumed.load() != parked.load()) {
+		cout << "FAIL: " << parked.load() << " parks but "
+		 << resumed.load() << " resumes" << endl;
+		failed = true;
+	}
+	if (parked.load() == 0) {
+		cout << "FAIL: no task ever parked" << endl;
+		failed = true;
+	}
+	if (out_of_order.load() != 0) {
+		cout << "FAIL: " << out_of_order.load()
+		 << " frames received out of order" << endl;
+		failed = true;
+	}
+
+	for (unsigned int i = 0; i < PAIRS; i++) {
+		delete async_a[i];
+		delete async_b[i];
+		delete a[i];
+		delete b[i];
+		delete physical_layer[i];
+	}
+	if (failed) {
+		return 1;
+	}
+	cout << "ok" << endl;
+	return 0;
+}
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "link_layer.h"
+#include "simulator.h"
+#include "timeval_operators.h"
+
+#ifndef BULK_TRANSFER_H
+#define BULK_TRANSFER_H
+
+using namespace std;
+
+// What the link layer benchmarks share. A benchmark includes this instead
+// of link_layer.h, builds its Physical_layer and pair of links as it
+// likes, and hands the links to a Bulk_transfer.
+
+inline double seconds(struct timeval t)
+{
+	return t.tv_sec+t.tv_usec/1000000.0;
+}
+
+// nearest rank: the smallest sample at or above fraction p of them
+inline unsigned long percentile(vector<unsigned long>& samples,double p)
+{
+	if (samples.empty()) {
+		return 0;
+	}
+	size_t k = (size_t) (p*samples.size()+0.999999);
+	k = k == 0 ? 0 : k-1;
+	nth_element(samples.begin(),samples.begin()+k,samples.end());
+	return samples[k];
+}
+
+// Bulk_transfer ----------------------------------------------------------
+
+// A one-way transfer of full-size frames from link a to link b. Every
+// frame carries its number, and b must deliver them in order. With a
+// Simulator, run its next event whenever neither side can make progress;
+// in real time, sleep 10 us instead and leave the core to the links'
+// threads. What each side put on the wire is in the interfaces'
+// Physical_layer_metrics, and what the links did in their Link_metrics
+template <class Link>
+class Bulk_transfer {
+public:
+	Bulk_transfer(Link& a0,Link& b0,Simulator* simulator0)
+	 : a(a0),b(b0),simulator(simulator0),latencies(NULL),
+	 receive_log(NULL),receive_log_arg(NULL)
+	{
+		if (simulator != NULL) {
+			clock = simulator;
+		} else {
+			clock = &real_clock;
+		}
+	}
+
+	// append each frame's latency, in microseconds from the send that
+	// accepted it to the receive that returned it
+	void set_latencies(vector<unsigned long>* latencies0)
+	{
+		latencies = latencies0;
+	}
+
+	// call log with the time since run began whenever b delivers a frame
+	void set_receive_log(void (*log)(void*,const struct timeval&),
+	 void* arg)
+	{
+		receive_log = log;
+		receive_log_arg = arg;
+	}
+
+	// send frames frames and receive them all; return false if the
+	// simulation stalls first. Exit if a frame arrives out of order
+	bool run(unsigned int frames)
+	{
+		unsigned char send_buffer[Link::MAXIMUM_DATA_LENGTH];
+		unsigned char receive_buffer[Link::MAXIMUM_DATA_LENGTH];
+		unsigned int send_count = 0;
+		unsigned int receive_count = 0;
+		vector<struct timeval> send_times;
+		if (latencies != NULL) {
+			send_times.resize(frames);
+		}
+		bool completed = true;
+
+		memset(send_buffer,0,sizeof(send_buffer));
+		gettimeofday(&wall_start,NULL);
+		start = clock->now();
+		while (receive_count < frames) {
+			bool idle = true;
+			while (send_count < frames
+			 && a.send(send_buffer,Link::MAXIMUM_DATA_LENGTH) > 0) {
+				if (latencies != NULL) {
+					send_times[send_count] = clock->now();
+				}
+				send_count++;
+				memcpy(send_buffer,&send_count,
+				 sizeof(send_count));
+				idle = false;
+			}
+			while (b.receive(receive_buffer) > 0) {
+				unsigned int k;
+				memcpy(&k,receive_buffer,sizeof(k));
+				if (k != receive_count) {
+					cerr << "out of order frame" << endl;
+					exit(1);
+				}
+				if (latencies != NULL) {
+					latencies->push_back(timeval_to_usec(
+					 clock->now()-send_times[k]));
+				}
+				if (receive_log != NULL) {
+					receive_log(receive_log_arg,
+					 clock->now()-start);
+				}
+				receive_count++;
+				idle = false;
+			}
+			if (!idle || receive_count == frames) {
+				continue;
+			}
+			if (simulator == NULL) {
+				usleep(10);
+			} else if (!simulator->step()) {
+				completed = false;
+				break;
+			}
+		}
+		stop = clock->now();
+		gettimeofday(&wall_stop,NULL);
+		return completed;
+	}
+
+	// link time and host time the last run took
+	double get_seconds(void) const
+	{
+		return seconds(stop-start);
+	}
+
+	double get_wall_seconds(void) const
+	{
+		return seconds(wall_stop-wall_start);
+	}
+private:
+	Link& a;
+	Link& b;
+	Simulator* simulator;
+	Real_clock real_clock;
+	Clock* clock;
+
+	vector<unsigned long>* latencies;
+	void (*receive_log)(void*,const struct timeval&);
+	void* receive_log_arg;
+
+	struct timeval start,stop,wall_start,wall_stop;
+};
+
+#endif
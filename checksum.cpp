@@ -0,0 +1,191 @@
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CHECKSUM_X86
+#endif
+
+#include "checksum.h"
+
+// ones_complement_checksum -----------------------------------------------
+
+// fold a 64-bit one's-complement accumulator to 16 bits and complement it
+static unsigned short fold(uint64_t sum)
+{
+	sum = (sum >> 32)+(sum & 0xffffffff);
+	sum = (sum >> 32)+(sum & 0xffffffff);
+	sum = (sum >> 16)+(sum & 0xffff);
+	sum = (sum >> 16)+(sum & 0xffff);
+	sum = (sum >> 16)+(sum & 0xffff);
+	return (unsigned short) ~sum;
+}
+
+// one's-complement sums can be taken over wider words and folded later
+// (RFC 1071 section 2); add 32-bit words into 64 bits, which cannot carry
+// out for any buffer shorter than 16 GB
+static uint64_t sum_words(const unsigned char buffer[],unsigned int length)
+{
+	uint64_t sum = 0;
+	unsigned int i = 0;
+
+#ifdef __SSE2__
+	// four 32-bit lanes; zero-extend each 16-bit word into a lane, and
+	// spill to sum before a lane could overflow
+	const __m128i zero = _mm_setzero_si128();
+	while (length-i >= 16) {
+		__m128i acc = zero;
+		unsigned int end = length-i > 16*8192 ? i+16*8192 : length & ~15u;
+		for (; i < end; i += 16) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(buffer+i));
+			acc = _mm_add_epi32(acc,_mm_unpacklo_epi16(v,zero));
+			acc = _mm_add_epi32(acc,_mm_unpackhi_epi16(v,zero));
+		}
+		uint32_t lanes[4];
+		_mm_storeu_si128((__m128i*)lanes,acc);
+		sum += (uint64_t) lanes[0]+lanes[1]+lanes[2]+lanes[3];
+	}
+#endif
+	for (; length-i >= 4; i += 4) {
+		uint32_t w;
+		memcpy(&w,buffer+i,4);
+		sum += w;
+	}
+	// trailing bytes, zero padded to a word
+	if (i < length) {
+		uint32_t w = 0;
+		memcpy(&w,buffer+i,length-i);
+		sum += w;
+	}
+	return sum;
+}
+
+unsigned short ones_complement_checksum(const unsigned char buffer[],
+ unsigned int length)
+{
+	return fold(sum_words(buffer,length));
+}
+
+unsigned short ones_complement_checksum_scalar(const unsigned char buffer[],
+ unsigned int length)
+{
+	unsigned long sum = 0;
+	unsigned int i = 0;
+
+	for (; length-i > 1; i += 2) {
+		unsigned short w;
+		memcpy(&w,buffer+i,2);
+		sum += w;
+	}
+	// handle the trailing byte, if present
+	if (i < length) {
+		unsigned short w = 0;
+		memcpy(&w,buffer+i,1);
+		sum += w;
+	}
+	return fold(sum);
+}
+
+// crc32c -----------------------------------------------------------------
+
+// slice-by-8 tables for the reflected Castagnoli polynomial
+struct Crc32c_tables {
+	uint32_t t[8][256];
+
+	Crc32c_tables()
+	{
+		for (unsigned int i = 0; i < 256; i++) {
+			uint32_t crc = i;
+			for (int j = 0; j < 8; j++) {
+				crc = (crc >> 1) ^ (0x82f63b78 & (0-(crc & 1)));
+			}
+			t[0][i] = crc;
+		}
+		for (unsigned int i = 0; i < 256; i++) {
+			for (int k = 1; k < 8; k++) {
+				t[k][i] = (t[k-1][i] >> 8) ^ t[0][t[k-1][i] & 0xff];
+			}
+		}
+	}
+};
+
+// built on first use, so link layers created during static initialization
+// can checksum safely
+static const Crc32c_tables& crc32c_tables(void)
+{
+	static const Crc32c_tables tables;
+	return tables;
+}
+
+unsigned int crc32c_table(const unsigned char buffer[],unsigned int length)
+{
+	const uint32_t (*t)[256] = crc32c_tables().t;
+	uint32_t crc = 0xffffffff;
+	unsigned int i = 0;
+
+	// eight bytes per step
+	for (; length-i >= 8; i += 8) {
+		uint32_t lo = crc ^ (buffer[i] | buffer[i+1] << 8
+		 | buffer[i+2] << 16 | (uint32_t) buffer[i+3] << 24);
+		crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff]
+		 ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24]
+		 ^ t[3][buffer[i+4]] ^ t[2][buffer[i+5]]
+		 ^ t[1][buffer[i+6]] ^ t[0][buffer[i+7]];
+	}
+	for (; i < length; i++) {
+		crc = (crc >> 8) ^ t[0][(crc ^ buffer[i]) & 0xff];
+	}
+	return ~crc;
+}
+
+#ifdef CHECKSUM_X86
+bool crc32c_sse42_supported(void)
+{
+	static bool supported = __builtin_cpu_supports("sse4.2");
+	return supported;
+}
+
+__attribute__((target("sse4.2")))
+unsigned int crc32c_sse42(const unsigned char buffer[],unsigned int length)
+{
+	unsigned int i = 0;
+#ifdef __x86_64__
+	uint64_t crc = 0xffffffff;
+	for (; length-i >= 8; i += 8) {
+		uint64_t w;
+		memcpy(&w,buffer+i,8);
+		crc = _mm_crc32_u64(crc,w);
+	}
+	uint32_t crc32 = (uint32_t) crc;
+#else
+	uint32_t crc32 = 0xffffffff;
+#endif
+	for (; length-i >= 4; i += 4) {
+		uint32_t w;
+		memcpy(&w,buffer+i,4);
+		crc32 = _mm_crc32_u32(crc32,w);
+	}
+	for (; i < length; i++) {
+		crc32 = _mm_crc32_u8(crc32,buffer[i]);
+	}
+	return ~crc32;
+}
+#else
+bool crc32c_sse42_supported(void)
+{
+	return false;
+}
+
+unsigned int crc32c_sse42(const unsigned char buffer[],unsigned int length)
+{
+	return crc32c_table(buffer,length);
+}
+#endif
+
+unsigned int crc32c(const unsigned char buffer[],unsigned int length)
+{
+	if (crc32c_sse42_supported()) {
+		return crc32c_sse42(buffer,length);
+	}
+	return crc32c_table(buffer,length);
+}
@@ -0,0 +1,28 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+// Frame checksums. All functions read buffer[0..length-1] in place.
+
+enum Checksum_mode {ONES_COMPLEMENT, CRC32C};
+
+// Internet (RFC 1071) checksum: complement of the one's-complement sum of
+// native-order 16-bit words, a trailing odd byte padded with zero
+unsigned short ones_complement_checksum(const unsigned char buffer[],
+ unsigned int length);
+
+// the same sum one 16-bit word at a time; reference for benchmarks
+unsigned short ones_complement_checksum_scalar(const unsigned char buffer[],
+ unsigned int length);
+
+// CRC-32C (Castagnoli); uses the SSE4.2 crc32 instruction when the CPU
+// has it and crc32c_table otherwise
+unsigned int crc32c(const unsigned char buffer[],unsigned int length);
+
+unsigned int crc32c_table(const unsigned char buffer[],unsigned int length);
+
+// true if crc32c_sse42 may be called
+bool crc32c_sse42_supported(void);
+
+unsigned int crc32c_sse42(const unsigned char buffer[],unsigned int length);
+
+#endif
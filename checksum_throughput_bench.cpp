@@ -0,0 +1,79 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include <time.h>
+
+#include "checksum.h"
+
+using namespace std;
+
+// Checksum benchmark: bytes/sec of each checksum variant over a range of
+// buffer sizes, from a minimal frame up to a large jumbo buffer.
+
+typedef unsigned int (*Checksum_function)(const unsigned char[],unsigned int);
+
+unsigned int ones_complement(const unsigned char buffer[],unsigned int length)
+{
+	return ones_complement_checksum(buffer,length);
+}
+
+unsigned int ones_complement_scalar(const unsigned char buffer[],
+ unsigned int length)
+{
+	return ones_complement_checksum_scalar(buffer,length);
+}
+
+double now()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec+t.tv_nsec/1e9;
+}
+
+// run f over buffer for about 0.1 s; return bytes/sec
+double measure(Checksum_function f,const unsigned char buffer[],
+ unsigned int length)
+{
+	volatile unsigned int sink = 0;
+	unsigned long iterations = 0;
+	unsigned long batch = 1+(1<<20)/length;
+	double start = now(),elapsed;
+
+	do {
+		for (unsigned long i = 0; i < batch; i++) {
+			sink += f(buffer,length);
+		}
+		iterations += batch;
+		elapsed = now()-start;
+	} while (elapsed < 0.1);
+
+	return iterations*(double)length/elapsed;
+}
+
+int main(int argc,char* argv[])
+{
+	unsigned int lengths[] = {20,36,100,256,1500,9000,65536};
+	unsigned char* buffer = new unsigned char[65536];
+	for (unsigned int i = 0; i < 65536; i++) {
+		buffer[i] = rand();
+	}
+
+	cout << "length\tscalar\tvector\tcrc32c-table\tcrc32c-sse4.2"
+	 << "\t(MB/s)" << endl;
+	for (unsigned int i = 0; i < sizeof(lengths)/sizeof(lengths[0]); i++) {
+		unsigned int n = lengths[i];
+		cout << n << fixed << setprecision(0)
+		 << "\t" << measure(ones_complement_scalar,buffer,n)/1e6
+		 << "\t" << measure(ones_complement,buffer,n)/1e6
+		 << "\t" << measure(crc32c_table,buffer,n)/1e6 << "\t";
+		if (crc32c_sse42_supported()) {
+			cout << measure(crc32c_sse42,buffer,n)/1e6;
+		} else {
+			cout << "n/a";
+		}
+		cout << endl;
+	}
+
+	delete[] buffer;
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "replay.h"
+
+using namespace std;
+
+// Converts a capture in CSV to a replay file for Impair::set_replay. Each
+// line is one frame sent, in order:
+//
+//	delay,dropped,corrupted
+//
+// delay in microseconds, dropped and corrupted 0 or 1. A dropped frame's
+// delay does not matter, but must be there. Blank lines, lines starting
+// with '#' and a first line of column names are skipped.
+
+// parse an unsigned number from *p up to a ',' or the end of the line
+bool parse_field(char*& p,unsigned long& value,bool last)
+{
+	while (*p == ' ' || *p == '\t') {
+		p++;
+	}
+	if (!isdigit((unsigned char) *p)) {
+		return false;
+	}
+	char* end;
+	value = strtoul(p,&end,10);
+	p = end;
+	while (*p == ' ' || *p == '\t') {
+		p++;
+	}
+	if (last) {
+		return *p == '\0' || *p == '\n' || *p == '\r';
+	}
+	if (*p != ',') {
+		return false;
+	}
+	p++;
+	return true;
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 3) {
+		cout << "Syntax: " << argv[0] << " csv_file replay_file" << endl;
+		exit(1);
+	}
+	FILE* in = fopen(argv[1],"r");
+	if (in == NULL) {
+		cerr << "cannot read " << argv[1] << endl;
+		exit(1);
+	}
+	FILE* out = fopen(argv[2],"wb");
+	if (out == NULL) {
+		cerr << "cannot write " << argv[2] << endl;
+		exit(1);
+	}
+	static char out_buffer[1 << 20];
+	setvbuf(out,out_buffer,_IOFBF,sizeof(out_buffer));
+
+	// the event count goes in once it is known
+	Replay_file_header header;
+	memset(&header,0,sizeof(header));
+	memcpy(header.magic,REPLAY_MAGIC,sizeof(REPLAY_MAGIC));
+	header.version = REPLAY_VERSION;
+	header.record_length = sizeof(unsigned int);
+	fwrite(&header,sizeof(header),1,out);
+
+	unsigned long long dropped = 0;
+	unsigned long long corrupted = 0;
+	unsigned long long line_number = 0;
+	char line[256];
+	while (fgets(line,sizeof(line),in) != NULL) {
+		line_number++;
+		char* p = line;
+		while (*p == ' ' || *p == '\t') {
+			p++;
+		}
+		if (*p == '\0' || *p == '\n' || *p == '\r' || *p == '#'
+		 || (line_number == 1 && !isdigit((unsigned char) *p))) {
+			continue;
+		}
+		unsigned long delay,drop,corrupt;
+		if (!parse_field(p,delay,false) || !parse_field(p,drop,false)
+		 || !parse_field(p,corrupt,true)
+		 || delay > REPLAY_DELAY_MASK || drop > 1 || corrupt > 1) {
+			cerr << argv[1] << ":" << line_number << ": bad line" << endl;
+			exit(1);
+		}
+		unsigned int event = delay | (drop ? REPLAY_DROPPED : 0)
+		 | (corrupt ? REPLAY_CORRUPTED : 0);
+		fwrite(&event,sizeof(event),1,out);
+		header.events++;
+		dropped += drop;
+		corrupted += corrupt;
+	}
+	fclose(in);
+	if (header.events == 0) {
+		cerr << argv[1] << " has no frames" << endl;
+		exit(1);
+	}
+	rewind(out);
+	fwrite(&header,sizeof(header),1,out);
+	if (ferror(out) || fclose(out) != 0) {
+		cerr << "cannot write " << argv[2] << endl;
+		exit(1);
+	}
+
+	cout << header.events << " frames, " << dropped << " dropped, "
+	 << corrupted << " corrupted" << endl;
+	return 0;
+}
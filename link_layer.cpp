@@ -1,262 +1,1373 @@
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/eventfd.h>
+
+#include "checksum.h"
 #include "link_layer.h"
 #include "timeval_operators.h"
 
-unsigned short checksum(struct Packet);
-pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-unsigned int numseq;
-
-Link_layer::Link_layer(Physical_layer_interface* physical_layer_interface,
-                       unsigned int num_sequence_numbers,
-                       unsigned int max_send_window_size,unsigned int timeout)
+template <unsigned int MTU,class Header>
+Basic_link_layer<MTU,Header>::Basic_link_layer(
+    Physical_layer_interface* physical_layer_interface,
+    unsigned int num_sequence_numbers,
+    unsigned int max_send_window_size,unsigned int timeout,
+    Arq_mode arq_mode,unsigned int receive_depth,
+    Checksum_mode checksum_mode,Reactor* reactor)
+    : event(&Basic_link_layer::run_event,this),
+      reactor_event(&Basic_link_layer::run_event,this),
+      send_ring(2*max_send_window_size), receive_ring(receive_depth)
 {
-    this->physical_layer_interface = physical_layer_interface;
+    if (max_send_window_size == 0
+        || max_send_window_size >= num_sequence_numbers
+        || receive_depth == 0)
+    {
+        throw Link_layer_exception();
+    }
+    // selective repeat needs send and receive windows that cannot overlap
+    // in sequence space, and a sack bit for every frame in the window
+    if (arq_mode == SELECTIVE_REPEAT
+        && (max_send_window_size > num_sequence_numbers/2
+            || max_send_window_size > SACK_BITS))
+    {
+        throw Link_layer_exception();
+    }
+    // every seq must fit the header
+    if (num_sequence_numbers-1 > numeric_limits<decltype(Header::seq)>::max())
+    {
+        throw Link_layer_exception();
+    }
     
-    limit = max_send_window_size;
+    this->physical_layer_interface = physical_layer_interface;
+    this->arq_mode = arq_mode;
+    this->checksum_mode = checksum_mode;
+    this->num_sequence_numbers = num_sequence_numbers;
+    this->max_send_window_size = max_send_window_size;
     
-    numseq = num_sequence_numbers;
+    window.congestion = INITIAL_WINDOW < max_send_window_size ? INITIAL_WINDOW
+        : max_send_window_size;
+    window.threshold = max_send_window_size;
+    window.receive = max_send_window_size;
+    window.limit = window.congestion;
+    window_acked = 0;
+    window_log = NULL;
+    window_log_arg = NULL;
     
-    receive_buffer_length = 0;
+    sleeping = false;
+    receive_stalled = false;
     
     next_send_seq = 0;
     next_receive_seq = 0;
     last_receive_ack = 0;
+    last_receive_sack = 0;
+    
+    if (arq_mode == SELECTIVE_REPEAT)
+    {
+        reorder_buffer.resize(num_sequence_numbers);
+        reorder_valid.resize(num_sequence_numbers,false);
+    }
     
     send_queue_size = 0;
+    ring_queued = 0;
+    timer_order = 0;
+    ack_pending = false;
+    ack_frames = 0;
+    channel_busy = false;
+    
+    rtt.srtt = 0;
+    rtt.rttvar = 0;
+    rtt.min_rtt = 0;
+    base_rto = timeout < MINIMUM_RTO ? MINIMUM_RTO
+        : (timeout > MAXIMUM_RTO ? MAXIMUM_RTO : timeout);
+    rtt.rto = base_rto;
+    rtt.samples = 0;
+    rtt.backoffs = 0;
+    
+    listener = NULL;
+    listener_arg = NULL;
+    listener_pending = false;
+    
+    clock = physical_layer_interface->get_clock();
+    simulator = physical_layer_interface->get_simulator();
+    this->reactor = reactor;
+    // a reactor runs in real time
+    if (simulator != NULL && reactor != NULL)
+    {
+        throw Link_layer_exception();
+    }
     
-    timeval_timeout.tv_usec = timeout;
+    pthread_mutex_init(&mutex,NULL);
+    running = true;
     
-    if (pthread_create(&thread,NULL,&Link_layer::loop,this) < 0)
+    if (reactor != NULL)
+    {
+        reactor->attach(reactor_event);
+    }
+    if (simulator != NULL || reactor != NULL)
     {
+        // asleep until the first event: send and the physical layer wake
+        // us by scheduling one
+        wakeup_fd = -1;
+        sleeping = true;
+        physical_layer_interface->set_listener(&Basic_link_layer::wakeup,this);
+        return;
+    }
+    
+    wakeup_fd = eventfd(0,EFD_NONBLOCK);
+    if (wakeup_fd < 0)
+    {
+        pthread_mutex_destroy(&mutex);
+        throw Link_layer_exception();
+    }
+    
+    physical_layer_interface->set_listener(&Basic_link_layer::wakeup,this);
+    
+    if (pthread_create(&thread,NULL,&Basic_link_layer::loop,this) != 0)
+    {
+        physical_layer_interface->set_listener(NULL,NULL);
+        pthread_mutex_destroy(&mutex);
+        close(wakeup_fd);
         throw Link_layer_exception();
     }
 }
 
-unsigned int Link_layer::send(unsigned char buffer[],unsigned int length)
+template <unsigned int MTU,class Header>
+Basic_link_layer<MTU,Header>::~Basic_link_layer()
+{
+    // after this returns the physical layer can no longer call wakeup
+    physical_layer_interface->set_listener(NULL,NULL);
+    
+    pthread_mutex_lock(&mutex);
+    running = false;
+    pthread_mutex_unlock(&mutex);
+    
+    if (simulator != NULL)
+    {
+        simulator->cancel_timer(event);
+        pthread_mutex_destroy(&mutex);
+        return;
+    }
+    if (reactor != NULL)
+    {
+        // waits out a pass running on the reactor's thread
+        reactor->detach(reactor_event);
+        pthread_mutex_destroy(&mutex);
+        return;
+    }
+    
+    wakeup(this);
+    
+    pthread_join(thread,NULL);
+    pthread_mutex_destroy(&mutex);
+    close(wakeup_fd);
+}
+
+template <unsigned int MTU,class Header>
+unsigned int Basic_link_layer<MTU,Header>::send(unsigned char buffer[],
+                                                unsigned int length)
 {
-    cout<<"\t\tSend. \n";
     if (length == 0 || length >MAXIMUM_DATA_LENGTH)
     {
         throw Link_layer_exception();
     }
-    pthread_mutex_lock(&mutex);
     
-    if(send_queue_size < limit)
+    unsigned char* data = send_loan();
+    if (data == NULL)
     {
-        struct Timed_packet P;
-        
-        gettimeofday(&P.send_time,NULL);
-        
-        for(unsigned int i=0;i<length;i++)
+        return 0;
+    }
+    memcpy(data,buffer,length);
+    send_commit(length);
+    return length;
+}
+
+template <unsigned int MTU,class Header>
+unsigned int Basic_link_layer<MTU,Header>::send_many(unsigned char buffer[],
+                                                     unsigned int length[],
+                                                     unsigned int num_frames)
+{
+    for(unsigned int n = 0; n < num_frames; n++)
+    {
+        if (length[n] == 0 || length[n] > MAXIMUM_DATA_LENGTH)
         {
-            P.packet.data[i] = buffer[i];
+            throw Link_layer_exception();
         }
-        P.packet.header.data_length = length;
-        P.packet.header.seq = next_send_seq;
+    }
+    
+    unsigned int n = 0;
+    Timed_packet* P;
+    while (n < num_frames && (P = send_ring.back()) != NULL)
+    {
+        memcpy(P->packet.data,buffer + n*MAXIMUM_DATA_LENGTH,length[n]);
+        P->packet.header.data_length = length[n];
+        send_ring.push();
+        n++;
+    }
+    if (n > 0)
+    {
+        notify_loop();
+    }
+    return n;
+}
+
+template <unsigned int MTU,class Header>
+unsigned char* Basic_link_layer<MTU,Header>::send_loan()
+{
+    Timed_packet* P = send_ring.back();
+    if (P == NULL)
+    {
+        return NULL;
+    }
+    return P->packet.data;
+}
+
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::send_commit(unsigned int length)
+{
+    Timed_packet* P = send_ring.back();
+    if (P == NULL || length == 0 || length > MAXIMUM_DATA_LENGTH)
+    {
+        throw Link_layer_exception();
+    }
+    P->packet.header.data_length = length;
+    send_ring.push();
+    
+    notify_loop();
+}
+
+template <unsigned int MTU,class Header>
+unsigned int Basic_link_layer<MTU,Header>::receive(unsigned char buffer[])
+{
+    unsigned int N = pop_received(buffer);
+    if (N > 0)
+    {
+        notify_receive_space();
+    }
+    return N;
+}
+
+template <unsigned int MTU,class Header>
+unsigned int Basic_link_layer<MTU,Header>::receive_many(
+    unsigned char buffer[],unsigned int length[],unsigned int max_frames)
+{
+    unsigned int n = 0;
+    
+    while (n < max_frames
+           && (length[n] = pop_received(buffer + n*MAXIMUM_DATA_LENGTH)) > 0)
+    {
+        n++;
+    }
+    if (n > 0)
+    {
+        notify_receive_space();
+    }
+    return n;
+}
+
+template <unsigned int MTU,class Header>
+const unsigned char* Basic_link_layer<MTU,Header>::receive_loan(
+    unsigned int& length)
+{
+    Packet* slot = receive_ring.front();
+    if (slot == NULL)
+    {
+        return NULL;
+    }
+    length = slot->header.data_length;
+    return slot->data;
+}
+
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::receive_release()
+{
+    if (receive_ring.front() == NULL)
+    {
+        throw Link_layer_exception();
+    }
+    receive_ring.pop();
+    notify_receive_space();
+}
+
+template <unsigned int MTU,class Header>
+bool Basic_link_layer<MTU,Header>::can_send()
+{
+    return !send_ring.full();
+}
+
+template <unsigned int MTU,class Header>
+bool Basic_link_layer<MTU,Header>::can_receive()
+{
+    return !receive_ring.empty();
+}
+
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::set_listener(void (*listener)(void*),
+                                                void* listener_arg)
+{
+    pthread_mutex_lock(&mutex);
+    this->listener = listener;
+    this->listener_arg = listener_arg;
+    pthread_mutex_unlock(&mutex);
+}
+
+template <unsigned int MTU,class Header>
+Rtt_estimate Basic_link_layer<MTU,Header>::get_rtt_estimate()
+{
+    pthread_mutex_lock(&mutex);
+    Rtt_estimate estimate = rtt;
+    pthread_mutex_unlock(&mutex);
+    return estimate;
+}
+
+template <unsigned int MTU,class Header>
+Send_window Basic_link_layer<MTU,Header>::get_send_window()
+{
+    pthread_mutex_lock(&mutex);
+    Send_window current = window;
+    pthread_mutex_unlock(&mutex);
+    return current;
+}
+
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::set_window_log(
+    void (*window_log)(void*,const struct timeval&,const Send_window&),
+    void* window_log_arg)
+{
+    pthread_mutex_lock(&mutex);
+    this->window_log = window_log;
+    this->window_log_arg = window_log_arg;
+    pthread_mutex_unlock(&mutex);
+}
+
+template <unsigned int MTU,class Header>
+Link_metrics Basic_link_layer<MTU,Header>::get_metrics()
+{
+    Link_metrics m;
+    m.frames_sent = metrics.frames_sent.get();
+    m.retransmissions = metrics.retransmissions.get();
+    m.timeouts = metrics.timeouts.get();
+    m.acks_sent = metrics.acks_sent.get();
+    m.channel_busy = metrics.channel_busy.get();
+    m.frames_received = metrics.frames_received.get();
+    m.checksum_errors = metrics.checksum_errors.get();
+    m.frames_delivered = metrics.frames_delivered.get();
+    m.receive_full = metrics.receive_full.get();
+    m.discarded = metrics.discarded.get();
+    m.rtt = metrics.rtt.get();
+    m.send_queue = metrics.send_queue.get();
+    return m;
+}
+
+// wake the loop if it is blocked with a new frame in send_ring
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::notify_loop()
+{
+    // pairs with the fence in wait_for_work: either the loop sees our ring
+    // update before blocking, or we see it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed))
+    {
+        wakeup(this);
+    }
+}
+
+// wake the loop if it found receive_ring full
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::notify_receive_space()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (receive_stalled.load(std::memory_order_relaxed))
+    {
+        wakeup(this);
+    }
+}
+
+// loop thread: append a data frame to receive_ring; false if it is full
+template <unsigned int MTU,class Header>
+bool Basic_link_layer<MTU,Header>::push_received(const Packet& p)
+{
+    Packet* slot = receive_ring.back();
+    if (slot == NULL)
+    {
+        receive_stalled.store(true,std::memory_order_relaxed);
+        return false;
+    }
+    copy_data(slot->data,p.data,p.header.data_length);
+    slot->header.data_length = p.header.data_length;
+    receive_ring.push();
+    listener_pending = true;
+    metrics.frames_delivered.add();
+    return true;
+}
+
+// a frame's data between fixed-size buffers: short frames are copied
+// whole, at a length known at compile time
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::copy_data(unsigned char to[],
+                                             const unsigned char from[],
+                                             unsigned int length)
+{
+    if ((unsigned int) MAXIMUM_DATA_LENGTH <= FIXED_COPY_LENGTH)
+    {
+        memcpy(to,from,MAXIMUM_DATA_LENGTH);
+    }
+    else
+    {
+        memcpy(to,from,length);
+    }
+}
+
+// application thread: copy the oldest frame in receive_ring to buffer and
+// return its length, or return 0 if the ring is empty
+template <unsigned int MTU,class Header>
+unsigned int Basic_link_layer<MTU,Header>::pop_received(unsigned char buffer[])
+{
+    Packet* slot = receive_ring.front();
+    if (slot == NULL)
+    {
+        return 0;
+    }
+    unsigned int N = slot->header.data_length;
+    copy_data(buffer,slot->data,N);
+    receive_ring.pop();
+    return N;
+}
+
+// loop thread: give frames waiting in send_ring a seq and queue them in
+// place, as far as the window allows
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::accept_sent_packets()
+{
+    Timed_packet* P;
+    timeval current;
+    
+    if (send_queue_size >= window.limit || (P = send_ring.at(ring_queued)) == NULL)
+    {
+        return;
+    }
+    current = clock->now();
+    
+    do
+    {
+        P->send_time = current;
+        P->transmissions = 0;
+        P->acked = false;
+        P->packet.header.seq = next_send_seq;
         
         send_queue.push_back(P);
         send_queue_size++;
+        ring_queued++;
+        start_timer(*P);
         
         next_send_seq++;
-        if(next_send_seq==numseq)
+        if(next_send_seq==num_sequence_numbers)
         {
             next_send_seq = 0;
         }
+    }
+    while (send_queue_size < window.limit
+           && (P = send_ring.at(ring_queued)) != NULL);
+}
+
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::process_received_packet(const Packet& p)
+{
+    // a data frame taken in order can wait for company; a duplicate, a
+    // frame after a gap or one with no room is acknowledged at once, so
+    // the sender learns of it before its timer runs out
+    if (p.header.data_length > 0)
+    {
+        bool in_order = false;
+        bool taken = false;
         
-        pthread_mutex_unlock(&mutex);
-        return length;
+        if (arq_mode == SELECTIVE_REPEAT)
+        {
+            // deliver the expected frame straight to receive_ring; buffer
+            // anything else inside the receive window
+            unsigned int offset = (p.header.seq+num_sequence_numbers-next_receive_seq)
+                % num_sequence_numbers;
+            if (p.header.seq < num_sequence_numbers
+                && offset < max_send_window_size
+                && !reorder_valid[p.header.seq])
+            {
+                taken = true;
+                if (offset == 0 && push_received(p))
+                {
+                    in_order = true;
+                    next_receive_seq++;
+                    if(next_receive_seq==num_sequence_numbers)
+                    {
+                        next_receive_seq = 0;
+                    }
+                }
+                else
+                {
+                    if (offset == 0)
+                    {
+                        metrics.receive_full.add();
+                    }
+                    Packet& buffered = reorder_buffer[p.header.seq];
+                    buffered.header = p.header;
+                    copy_data(buffered.data,p.data,p.header.data_length);
+                    reorder_valid[p.header.seq] = true;
+                }
+                deliver_buffered_packets();
+            }
+        }
+        else if(p.header.seq == next_receive_seq)
+        {
+            if (push_received(p))
+            {
+                taken = true;
+                in_order = true;
+                next_receive_seq++;
+                if(next_receive_seq==num_sequence_numbers)
+                {
+                    next_receive_seq = 0;
+                }
+            }
+            else
+            {
+                metrics.receive_full.add();
+            }
+        }
+        if (!taken)
+        {
+            metrics.discarded.add();
+        }
+        delay_ack(!in_order || (p.header.flags & ACK_NOW));
     }
-    else
+
+    // a frame overtaken on the path carries an older ack, sack and window
+    // than the frames already taken, and modulo the sequence space its
+    // ack may read as one acknowledging frames never received. Take them
+    // only from a frame acking at or ahead of last_receive_ack, and no
+    // further than the frames sent
+    unsigned int ahead = (p.header.ack+num_sequence_numbers-last_receive_ack)
+        % num_sequence_numbers;
+    unsigned int sent = (next_send_seq+num_sequence_numbers-last_receive_ack)
+        % num_sequence_numbers;
+    if (ahead <= sent)
     {
-        pthread_mutex_unlock(&mutex);
-        return 0;
+        last_receive_ack = p.header.ack;
+        last_receive_sack = p.header.sack;
+        window.receive = p.header.window;
     }
 }
 
-unsigned int Link_layer::receive(unsigned char buffer[])
+// selective repeat: move the in-order run of buffered frames up to the
+// application, stopping at a gap or a full receive_ring; return true if
+// next_receive_seq advanced
+template <unsigned int MTU,class Header>
+bool Basic_link_layer<MTU,Header>::deliver_buffered_packets()
 {
+    bool advanced = false;
     
-    pthread_mutex_lock(&mutex);
-    unsigned int N = receive_buffer_length;
-    if(N > 0)
+    while (reorder_valid[next_receive_seq])
+    {
+        if (!push_received(reorder_buffer[next_receive_seq]))
+        {
+            return advanced;
+        }
+        reorder_valid[next_receive_seq] = false;
+        advanced = true;
+        
+        next_receive_seq++;
+        if(next_receive_seq==num_sequence_numbers)
+        {
+            next_receive_seq = 0;
+        }
+    }
+    return advanced;
+}
+
+// bit i set if frame next_receive_seq+i is buffered; always 0 for go-back-N
+template <unsigned int MTU,class Header>
+unsigned int Basic_link_layer<MTU,Header>::get_sack()
+{
+    unsigned int sack = 0;
+    
+    if (arq_mode == SELECTIVE_REPEAT)
     {
-        for(unsigned int i = 0;i<N;i++)
+        for(unsigned int i = 0; i < max_send_window_size; i++)
         {
-            buffer[i] = receive_buffer[i];
+            if (reorder_valid[(next_receive_seq+i) % num_sequence_numbers])
+            {
+                sack |= 1u << i;
+            }
         }
-        receive_buffer_length = 0;
-        pthread_mutex_unlock(&mutex);
-        return N;
+    }
+    return sack;
+}
+
+// receive_ring space, as far as the header can count it
+template <unsigned int MTU,class Header>
+unsigned int Basic_link_layer<MTU,Header>::get_advertised_window()
+{
+    unsigned int space = receive_ring.space();
+    unsigned int limit = numeric_limits<decltype(Header::window)>::max();
+    return space < limit ? space : limit;
+}
+
+// send_queue holds consecutive seqs starting at its front, so the frame
+// with a given seq is found by offset
+template <unsigned int MTU,class Header>
+typename Basic_link_layer<MTU,Header>::Timed_packet*
+Basic_link_layer<MTU,Header>::find_queued_packet(unsigned int seq)
+{
+    if (send_queue_size == 0)
+    {
+        return NULL;
+    }
+    unsigned int offset = (seq+num_sequence_numbers-send_queue.front()->packet.header.seq)
+        % num_sequence_numbers;
+    if (offset >= send_queue_size)
+    {
+        return NULL;
+    }
+    return send_queue[offset];
+}
+
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::start_timer(Timed_packet& P)
+{
+    Retransmit_timer t;
+    t.deadline = P.send_time;
+    t.seq = P.packet.header.seq;
+    t.order = timer_order++;
+    P.timer_order = t.order;
+    timers.push(t);
+}
+
+// a retransmitted frame's ack is ambiguous (Karn), unless it comes back
+// sooner after the last transmission than any round trip yet: then it is
+// the first transmission's, and the timeout was spurious. Sampling those
+// keeps the estimate from seeing only the round trips short enough to
+// beat the timer, when frames long on the wire queue behind each other
+template <unsigned int MTU,class Header>
+bool Basic_link_layer<MTU,Header>::is_rtt_sample(const Timed_packet& P,
+                                                 const timeval& current)
+{
+    return P.transmissions == 1
+        || (P.transmissions > 1 && rtt.samples > 0
+            && timeval_to_usec(current - P.last_send_time) < rtt.min_rtt);
+}
+
+// RFC 6298: fold in one round trip, measured from a frame's only
+// transmission to the ack that first covers it
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::sample_rtt(const timeval& first_send_time)
+{
+    unsigned long r = timeval_to_usec(clock->now() - first_send_time);
+    if (rtt.samples == 0 || r < rtt.min_rtt)
+    {
+        rtt.min_rtt = r;
+    }
+    if (rtt.samples == 0)
+    {
+        rtt.srtt = r;
+        rtt.rttvar = r/2;
     }
     else
     {
-        pthread_mutex_unlock(&mutex);
+        unsigned long delta = rtt.srtt > r ? rtt.srtt-r : r-rtt.srtt;
+        rtt.rttvar = (3*rtt.rttvar+delta)/4;
+        rtt.srtt = (7*rtt.srtt+r)/8;
+    }
+    rtt.samples++;
+    metrics.rtt.record(r);
+    
+    // the variation term is at least MINIMUM_RTO, which also stands in
+    // for the clock granularity, and half the round trip: a steady path
+    // lets rttvar decay to nothing, and the window growing by a frame or
+    // two then delays the acks past the timeout
+    unsigned long margin = 4*rtt.rttvar > rtt.srtt/2 ? 4*rtt.rttvar
+        : rtt.srtt/2;
+    base_rto = rtt.srtt + (margin > MINIMUM_RTO ? margin
+        : (unsigned long) MINIMUM_RTO);
+    if (base_rto > MAXIMUM_RTO)
+    {
+        base_rto = MAXIMUM_RTO;
+    }
+}
+
+// the oldest frame timed out: wait twice as long before the next
+// retransmission, until an ack covers new frames. Frames sent after it
+// were armed with the old timeout; like a single restarted timer, give
+// them the new one, or they all expire into the queue that delayed it.
+// Frames already due keep their place
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::back_off(const timeval& current)
+{
+    rtt.rto = 2*rtt.rto > MAXIMUM_RTO ? MAXIMUM_RTO : 2*rtt.rto;
+    rtt.backoffs++;
+    metrics.timeouts.add();
+    
+    // a loss: multiplicative decrease, by half if the path was queueing
+    // (congestion), by a fifth if not (a random loss, as in TCP Veno).
+    // Neither a probe of a closed receive window nor a timeout still
+    // guessed before the first round trip says anything about the path
+    if (window.receive > 0 && rtt.samples > 0)
+    {
+        Send_window before = window;
+        if (get_path_backlog() > DELAY_BETA)
+        {
+            window.threshold = window.congestion/2;
+        }
+        else
+        {
+            window.threshold = window.congestion-window.congestion/5;
+        }
+        if (window.threshold == 0)
+        {
+            window.threshold = 1;
+        }
+        window.congestion = window.threshold;
+        window_acked = 0;
+        update_window(before);
+    }
+    
+    timeval deadline = current + usec_to_timeval(rtt.rto);
+    for (unsigned int i = 0; i < send_queue_size; i++)
+    {
+        Timed_packet* P = send_queue[i];
+        if (!P->acked && current < P->send_time && P->send_time < deadline)
+        {
+            P->send_time = deadline;
+            start_timer(*P);
+        }
+    }
+}
+
+// frames of ours waiting in queues along the path, from how far the
+// smoothed round trip exceeds the shortest one (TCP Vegas)
+template <unsigned int MTU,class Header>
+unsigned int Basic_link_layer<MTU,Header>::get_path_backlog()
+{
+    if (rtt.samples == 0 || rtt.srtt < rtt.min_rtt+MINIMUM_QUEUE_DELAY)
+    {
         return 0;
     }
+    return window.congestion*(rtt.srtt-rtt.min_rtt)/rtt.srtt;
 }
 
-void Link_layer::process_received_packet(struct Packet p)
+// slow start below the threshold, until the path starts queueing; then
+// once per window of acks, one frame more while the backlog is below
+// DELAY_ALPHA and one less while it is above DELAY_BETA
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::open_window(unsigned int acked)
 {
-    if(p.header.seq == next_receive_seq)
+    unsigned int backlog = get_path_backlog();
+    for (; acked > 0; acked--)
     {
-        if (p.header.data_length > 0)
+        if (window.congestion < window.threshold)
         {
-            if(receive_buffer_length == 0)
+            if (backlog > DELAY_BETA)
             {
-                for(unsigned int i = 0; i < p.header.data_length; i++)
-                {
-                    receive_buffer[i] = p.data[i];
-                }
-                
-                receive_buffer_length = p.header.data_length;
-                
-                next_receive_seq++;
-                if(next_receive_seq==numseq)
-                {
-                    next_receive_seq = 0;
-                }
+                window.threshold = window.congestion;
+            }
+            else
+            {
+                window.congestion++;
             }
         }
-        else
+        else if (++window_acked >= window.congestion)
         {
-            next_receive_seq++;
-            if(next_receive_seq==numseq)
+            window_acked = 0;
+            if (backlog < DELAY_ALPHA)
             {
-                next_receive_seq = 0;
+                window.congestion++;
+            }
+            else if (backlog > DELAY_BETA && window.congestion > 1)
+            {
+                window.congestion--;
             }
         }
     }
-    last_receive_ack = p.header.ack;
+    if (window.congestion > max_send_window_size)
+    {
+        window.congestion = max_send_window_size;
+    }
 }
 
-void Link_layer::remove_acked_packets()
+// recompute the limit after a change to the window, and log it
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::update_window(const Send_window& before)
 {
-    h = send_queue.begin();
-    unsigned int i=1;
+    window.limit = window.congestion < window.receive ? window.congestion
+        : window.receive;
+    if (window.limit == 0)
+    {
+        window.limit = 1;
+    }
+    
+    if (window_log != NULL
+        && (window.congestion != before.congestion
+            || window.threshold != before.threshold
+            || window.receive != before.receive
+            || window.limit != before.limit))
+    {
+        window_log(window_log_arg,clock->now(),window);
+    }
+}
+
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::remove_acked_packets()
+{
+    // the most recently sent frame this ack newly covers that times a
+    // round trip, see is_rtt_sample
+    Timed_packet* sample = NULL;
+    timeval current = clock->now();
+    
+    // only grow a window that is in use
+    Send_window before = window;
+    bool window_full = send_queue_size >= window.congestion;
+    unsigned int acked = 0;
+    bool advanced = false;
     
     if(send_queue_size >0 )
     {
-        while(h != send_queue.end())
+        // last_receive_ack acknowledges everything before it; an ack from
+        // behind the window gives a count larger than the queue
+        unsigned int n = (last_receive_ack+num_sequence_numbers
+            -send_queue.front()->packet.header.seq) % num_sequence_numbers;
+        if (n > 0 && n <= send_queue_size)
         {
-            if ((*h).packet.header.seq == (last_receive_ack-1))
+            // their timers go stale and are dropped when they reach the
+            // top; their slots go back to the application
+            for(unsigned int i = 0; i < n; i++)
+            {
+                if (!send_queue[i]->acked)
+                {
+                    acked++;
+                    if (is_rtt_sample(*send_queue[i],current))
+                    {
+                        sample = send_queue[i];
+                    }
+                }
+                send_ring.pop();
+                ring_queued--;
+                listener_pending = true;
+            }
+            if (sample != NULL)
             {
-                send_queue.erase(send_queue.begin(), send_queue.begin() + i);
-                send_queue_size-=(i);
-                return;
+                // the slot may be reused once popped; sample it now
+                sample_rtt(sample->first_send_time);
+                sample = NULL;
             }
-            i++;
-            h++;
+            
+            // the path delivers again: even an ack taking no sample ends
+            // the backoff, or under heavy loss, when few frames get
+            // through on their first try, it would only ever grow. Until
+            // the first sample the timeout is a guess that may be below
+            // the round trip, so only backoff can correct it
+            if (rtt.samples > 0)
+            {
+                rtt.rto = base_rto;
+            }
+            send_queue.erase(send_queue.begin(), send_queue.begin() + n);
+            send_queue_size-=n;
+            advanced = true;
+        }
+    }
+    
+    // selective repeat: stop retransmitting frames the receiver holds
+    unsigned int sack = last_receive_sack;
+    if (arq_mode == SELECTIVE_REPEAT)
+    {
+        for(unsigned int i = 0; sack != 0; i++, sack >>= 1)
+        {
+            if (sack & 1)
+            {
+                Timed_packet* P = find_queued_packet(
+                    (last_receive_ack+i) % num_sequence_numbers);
+                if (P != NULL && !P->acked)
+                {
+                    P->acked = true;
+                    acked++;
+                    if (is_rtt_sample(*P,current) && (sample == NULL
+                        || sample->first_send_time < P->first_send_time))
+                    {
+                        sample = P;
+                    }
+                }
+            }
+        }
+        if (sample != NULL)
+        {
+            sample_rtt(sample->first_send_time);
+            rtt.rto = base_rto;
+        }
+    }
+    
+    if (window_full)
+    {
+        open_window(acked);
+    }
+    update_window(before);
+    
+    // selective repeat: a receiver with no room sacks the frames it
+    // buffers, which leaves them no live timer, and its window update is
+    // an ack-only frame that may be lost. While the window is closed the
+    // front frame keeps a timer and probes it
+    if (window.receive == 0 && send_queue_size > 0
+        && send_queue.front()->acked && (advanced || before.receive > 0))
+    {
+        Timed_packet* P = send_queue.front();
+        P->send_time = clock->now() + usec_to_timeval(rtt.rto);
+        start_timer(*P);
+    }
+}
+
+// pop stale timers: frames acked, sacked or already rescheduled. A
+// sacked front frame probes a closed receive window
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::discard_stale_timers()
+{
+    while (!timers.empty())
+    {
+        Timed_packet* P = find_queued_packet(timers.top().seq);
+        if (P != NULL && P->timer_order == timers.top().order
+            && (!P->acked
+                || (P == send_queue.front() && window.receive == 0)))
+        {
+            return;
         }
+        timers.pop();
     }
 }
 
-void Link_layer::send_timed_out_packets()
+// only frames whose timers have expired are visited; they go to the
+// physical layer in batches of up to SEND_BATCH frames
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::send_timed_out_packets()
 {
-    h = send_queue.begin();
+    timeval current = clock->now();
+    channel_busy = false;
     
-    while(h != send_queue.end())
+    Retransmit_timer expired[SEND_BATCH];
+    unsigned char* buffers[SEND_BATCH];
+    unsigned int lengths[SEND_BATCH];
+    unsigned int ack = next_receive_seq;
+    unsigned int sack = get_sack();
+    unsigned int space = get_advertised_window();
+    
+    // an ack held back for the next frame costs the sender that frame's
+    // slot meanwhile: with only a few slots, ask for every ack at once
+    bool small_window = window.limit <= 2*ACK_EVERY;
+    
+    // go-back-N: the receiver drops everything after a lost frame, so
+    // once the oldest frame expires the whole queue is resent behind it,
+    // in order. Timers armed with different timeouts need not expire in
+    // send order by themselves
+    if (arq_mode == GO_BACK_N && send_queue_size > 0
+        && send_queue.front()->transmissions > 0
+        && send_queue.front()->send_time <= current)
     {
-        timeval current;
-        gettimeofday(&current,NULL);
-        
-        if (current > (*h).send_time)
+        for (unsigned int i = 0; i < send_queue_size; i++)
+        {
+            send_queue[i]->send_time = current;
+            start_timer(*send_queue[i]);
+        }
+    }
+    
+    while (true)
+    {
+        unsigned int count = 0;
+        for (discard_stale_timers();
+             count < SEND_BATCH && !timers.empty()
+                 && timers.top().deadline <= current;
+             discard_stale_timers())
         {
-            (*h).packet.header.ack = next_receive_seq;
-            (*h).packet.header.checksum = checksum((*h).packet);
+            expired[count] = timers.top();
+            timers.pop();
             
-            if (physical_layer_interface->send((unsigned char *)&((*h).packet), ((*h).packet.header.data_length + sizeof(struct Packet_header))))
+            Timed_packet* P = find_queued_packet(expired[count].seq);
+            P->packet.header.ack = ack;
+            P->packet.header.sack = sack;
+            P->packet.header.window = space;
+            P->packet.header.flags = small_window ? ACK_NOW : 0;
+            buffers[count] = (unsigned char *)&(P->packet);
+            lengths[count] = P->packet.header.data_length + HEADER_LENGTH;
+            count++;
+        }
+        if (count == 0)
+        {
+            break;
+        }
+        
+        // after the last frame due, the window is full or the application
+        // has nothing queued: ask for its ack without delay
+        if (timers.empty() || current < timers.top().deadline)
+        {
+            find_queued_packet(expired[count-1].seq)->packet.header.flags = ACK_NOW;
+        }
+        for (unsigned int i = 0; i < count; i++)
+        {
+            set_checksum(*(Packet*) buffers[i]);
+        }
+        
+        unsigned int n = physical_layer_interface->send_many(buffers,lengths,count);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (i < n)
             {
-                gettimeofday(&current,NULL);
-                current = current + timeval_timeout;
-                (*h).send_time = current;
+                Timed_packet* P = find_queued_packet(expired[i].seq);
+                if (P->transmissions == 0)
+                {
+                    P->first_send_time = current;
+                    metrics.frames_sent.add();
+                    metrics.send_queue.record(send_queue_size);
+                }
+                else
+                {
+                    metrics.retransmissions.add();
+                    // frames that expired along with an earlier oldest
+                    // frame were armed before its backoff: once per loss
+                    if (P == send_queue.front() && P->backoffs == rtt.backoffs)
+                    {
+                        back_off(current);
+                    }
+                }
+                P->transmissions++;
+                P->last_send_time = current;
+                P->backoffs = rtt.backoffs;
+                P->send_time = current + usec_to_timeval(rtt.rto);
+                start_timer(*P);
+                ack_pending = false;
+            }
+            else
+            {
+                // still due; keeps its place in the expiry order
+                timers.push(expired[i]);
             }
         }
-        h++;
+        if (n < count)
+        {
+            // the physical layer wakes us when the channel frees up
+            channel_busy = true;
+            metrics.channel_busy.add();
+            return;
+        }
     }
 }
 
-void Link_layer::generate_ack_packet()
+// receive side: note a received data frame (now = false), or something
+// the sender must hear of at once (now = true), for the pending ack
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::delay_ack(bool now)
 {
-    if(send_queue_size == 0)
+    timeval current = clock->now();
+    if (!ack_pending)
     {
-        //cout << "Gen Ack\n";
-        Timed_packet P;
-        gettimeofday(&(P.send_time),NULL);
-        
-        P.packet.header.seq = next_send_seq;
-        P.packet.header.data_length = 0;
-        
-        next_send_seq++;
-        if(next_send_seq==numseq)
+        ack_pending = true;
+        ack_frames = 0;
+        ack_deadline = current + usec_to_timeval(ACK_DELAY);
+    }
+    if (now || ++ack_frames >= ACK_EVERY)
+    {
+        ack_deadline = current;
+    }
+}
+
+// send the pending ack on its own once it is due and no data frame has
+// carried it. It takes no seq and is never retransmitted: if it is lost,
+// the sender's retransmission draws another
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::send_ack_packet()
+{
+    if (!ack_pending || channel_busy || clock->now() < ack_deadline)
+    {
+        return;
+    }
+    
+    ack_packet.header.seq = next_send_seq;
+    ack_packet.header.ack = next_receive_seq;
+    ack_packet.header.data_length = 0;
+    ack_packet.header.flags = 0;
+    ack_packet.header.sack = get_sack();
+    ack_packet.header.window = get_advertised_window();
+    set_checksum(ack_packet);
+    
+    if (physical_layer_interface->send((unsigned char *)&ack_packet,
+                                       HEADER_LENGTH))
+    {
+        ack_pending = false;
+        metrics.acks_sent.add();
+    }
+    else
+    {
+        // the physical layer wakes us when the channel frees up
+        channel_busy = true;
+        metrics.channel_busy.add();
+    }
+}
+
+// called with mutex held; one pass over everything the loop has to do
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::process()
+{
+    // read each frame where the physical layer delivered it
+    const unsigned char* frame;
+    unsigned int N;
+    while ((frame = physical_layer_interface->receive_loan(N)) != NULL)
+    {
+        const Packet& P = *(const Packet*) frame;
+        metrics.frames_received.add();
+        if(N >= HEADER_LENGTH
+           && N <= HEADER_LENGTH + MAXIMUM_DATA_LENGTH
+           && P.header.data_length == N - HEADER_LENGTH
+           && checksum_ok(P))
         {
-            next_send_seq = 0;
+            process_received_packet(P);
         }
+        else
+        {
+            metrics.checksum_errors.add();
+        }
+        physical_layer_interface->receive_release();
+    }
+    remove_acked_packets();
+    
+    // the application drained a full receive_ring: tell the sender the
+    // window is open again
+    if (receive_stalled.load(std::memory_order_relaxed))
+    {
+        receive_stalled.store(false,std::memory_order_relaxed);
+        if (arq_mode == SELECTIVE_REPEAT)
+        {
+            deliver_buffered_packets();
+        }
+        delay_ack(true);
+    }
+    
+    accept_sent_packets();
+    send_timed_out_packets();
+    send_ack_packet();
+    
+    if (listener_pending && listener != NULL)
+    {
+        listener(listener_arg);
+    }
+    listener_pending = false;
+}
+
+template <unsigned int MTU,class Header>
+void* Basic_link_layer<MTU,Header>::loop(void* thread_creator)
+{
+    Basic_link_layer* link_layer = ((Basic_link_layer*) thread_creator);
+    
+    pthread_mutex_lock(&link_layer->mutex);
+    while (link_layer->running)
+    {
+        link_layer->process();
+        link_layer->wait_for_work();
+    }
+    pthread_mutex_unlock(&link_layer->mutex);
+    return NULL;
+}
+
+// simulator and reactor counterpart of loop: one pass, then schedule the
+// next one for when wait_for_work would have woken
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::run_event(void* event_creator)
+{
+    Basic_link_layer* link_layer = ((Basic_link_layer*) event_creator);
+    timeval current = link_layer->clock->now();
+    
+    pthread_mutex_lock(&link_layer->mutex);
+    if (link_layer->running)
+    {
+        link_layer->sleeping.store(false,std::memory_order_relaxed);
+        link_layer->process();
         
-        send_queue.push_back(P);
-        send_queue_size++;
+        timeval deadline;
+        bool has_deadline = link_layer->get_deadline(deadline);
+        // on a reactor send runs on other threads: as in wait_for_work,
+        // either we see its frame or it sees us asleep and wakes us
+        link_layer->sleeping.store(true,std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (link_layer->has_work())
+        {
+            link_layer->schedule_event(current);
+        }
+        else if (has_deadline)
+        {
+            link_layer->schedule_event(deadline);
+        }
     }
+    pthread_mutex_unlock(&link_layer->mutex);
 }
 
-void* Link_layer::loop(void* thread_creator)
+// simulator or reactor mode: make sure the loop runs by time
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::schedule_event(const timeval& time)
 {
-    const unsigned int LOOP_INTERVAL = 10;
-    Link_layer* link_layer = ((Link_layer*) thread_creator);
-    Packet P;
+    if (reactor != NULL)
+    {
+        reactor->set_timer(reactor_event,time);
+    }
+    else if (!event.is_scheduled() || time < event.get_time())
+    {
+        simulator->set_timer(event,time);
+    }
+}
+
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::wakeup(void* link_layer0)
+{
+    Basic_link_layer* link_layer = (Basic_link_layer*) link_layer0;
+    uint64_t one = 1;
     
-    while (true)
+    if (link_layer->simulator != NULL)
     {
-        pthread_mutex_lock(&mutex);
-        link_layer->physical_layer_interface->receive((unsigned char*)&P);
-        unsigned int N = P.header.data_length + sizeof(struct Packet_header);
-        if(N > 0)
+        link_layer->schedule_event(link_layer->simulator->now());
+        return;
+    }
+    if (link_layer->reactor != NULL)
+    {
+        // due at once, queued by time with the shard's other timers so a
+        // busy link cannot starve their retransmissions
+        link_layer->reactor->set_timer(link_layer->reactor_event,
+                                       link_layer->clock->now());
+        return;
+    }
+    
+    // a failed write means the counter is saturated: a wakeup is pending
+    ssize_t n = write(link_layer->wakeup_fd,&one,sizeof(one));
+    (void) n;
+}
+
+// called with mutex held; true if the application has queued frames the
+// window can take, or made room in a receive_ring the loop found full
+template <unsigned int MTU,class Header>
+bool Basic_link_layer<MTU,Header>::has_work()
+{
+    return (send_queue_size < window.limit && send_ring.at(ring_queued) != NULL)
+        || (receive_stalled.load(std::memory_order_relaxed)
+            && !receive_ring.full());
+}
+
+// called with mutex held; the time of the earliest retransmission,
+// delayed ack or frame arrival, if there is one
+template <unsigned int MTU,class Header>
+bool Basic_link_layer<MTU,Header>::get_deadline(timeval& deadline)
+{
+    timeval release_time;
+    bool has_deadline = false;
+    
+    if (!channel_busy)
+    {
+        discard_stale_timers();
+        if (!timers.empty())
         {
-            if(N >= HEADER_LENGTH
-               && N <= HEADER_LENGTH + MAXIMUM_DATA_LENGTH
-               && P.header.data_length <= MAXIMUM_DATA_LENGTH
-               && P.header.checksum == checksum(P))
-            {
-                link_layer->process_received_packet(P);
-                
-            }
+            deadline = timers.top().deadline;
+            has_deadline = true;
+        }
+        if (ack_pending && (!has_deadline || ack_deadline < deadline))
+        {
+            deadline = ack_deadline;
+            has_deadline = true;
         }
-        link_layer->remove_acked_packets();
-        link_layer->send_timed_out_packets();
-        pthread_mutex_unlock(&mutex);
-        
-        usleep(LOOP_INTERVAL);
-        
-        pthread_mutex_lock(&mutex);
-        link_layer->generate_ack_packet();
-        pthread_mutex_unlock(&mutex);
     }
-    return NULL;
+    if (physical_layer_interface->get_release_time(release_time)
+        && (!has_deadline || release_time < deadline))
+    {
+        deadline = release_time;
+        has_deadline = true;
+    }
+    return has_deadline;
 }
 
-unsigned short checksum(struct Packet p)
+// called with mutex held; sleeps until a frame arrives, the application
+// sends, the channel frees up, or the earliest retransmission is due
+template <unsigned int MTU,class Header>
+void Basic_link_layer<MTU,Header>::wait_for_work()
 {
-    unsigned long sum = 0;
-    struct Packet copy;
-    unsigned short* shortbuf;
-    unsigned int length;
+    timeval deadline;
+    bool has_deadline = get_deadline(deadline);
     
-    if (p.header.data_length > Link_layer::MAXIMUM_DATA_LENGTH) {
-        throw Link_layer_exception();
+    // pairs with the fence in notify_loop
+    sleeping.store(true,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (has_work())
+    {
+        sleeping.store(false,std::memory_order_relaxed);
+        return;
     }
+    pthread_mutex_unlock(&mutex);
     
-    copy = p;
-    copy.header.checksum = 0;
-    length = sizeof(Packet_header)+copy.header.data_length;
-    shortbuf = (unsigned short*) &copy;
+    struct pollfd pfd;
+    pfd.fd = wakeup_fd;
+    pfd.events = POLLIN;
     
-    while (length > 1) {
-        sum += *shortbuf++;
-        length -= 2;
+    if (has_deadline)
+    {
+        timeval current = clock->now();
+        struct timespec wait = {0,0};
+        if (deadline > current)
+        {
+            timeval remaining = deadline - current;
+            wait.tv_sec = remaining.tv_sec;
+            wait.tv_nsec = remaining.tv_usec * 1000;
+        }
+        ppoll(&pfd,1,&wait,NULL);
     }
-    // handle the trailing byte, if present
-    if (length == 1) {
-        sum += *(unsigned char*) shortbuf;
+    else
+    {
+        ppoll(&pfd,1,NULL,NULL);
     }
     
-    sum = (sum >> 16)+(sum & 0xffff);
-    sum = (~(sum+(sum >> 16)) & 0xffff);
-    return (unsigned short) sum;
-}
\ No newline at end of file
+    // reset the counter; fails harmlessly if woken by the deadline
+    uint64_t count;
+    ssize_t n = read(wakeup_fd,&count,sizeof(count));
+    (void) n;
+    
+    pthread_mutex_lock(&mutex);
+    sleeping.store(false,std::memory_order_relaxed);
+}
+
+// the checksum covers the frame after the checksum field; for the
+// Internet checksum that equals summing the whole frame with the field 0.
+// A header with a narrower field keeps the low bits
+template <class Packet>
+static unsigned int frame_checksum(Checksum_mode checksum_mode,
+                                   const Packet& p)
+{
+    const unsigned char* frame = (const unsigned char*) &p
+        + sizeof(p.header.checksum);
+    unsigned int length = sizeof(p.header) - sizeof(p.header.checksum)
+        + p.header.data_length;
+    
+    if (checksum_mode == CRC32C)
+    {
+        return crc32c(frame,length);
+    }
+    return ones_complement_checksum(frame,length);
+}
+
+template <unsigned int MTU,class Header>
+unsigned int Basic_link_layer<MTU,Header>::set_checksum(Packet& p)
+{
+    if (p.header.data_length > MAXIMUM_DATA_LENGTH)
+    {
+        throw Link_layer_exception();
+    }
+    p.header.checksum = frame_checksum(checksum_mode,p);
+    return p.header.checksum;
+}
+
+template <unsigned int MTU,class Header>
+bool Basic_link_layer<MTU,Header>::checksum_ok(const Packet& p)
+{
+    return p.header.data_length <= MAXIMUM_DATA_LENGTH
+        && p.header.checksum
+            == (decltype(p.header.checksum)) frame_checksum(checksum_mode,p);
+}
+
+// the configurations built into this library; another needs a line of
+// its own, and its MTU one in physical_layer.cpp
+template class Basic_link_layer<32,Compact_packet_header>;
+template class Basic_link_layer<100,Packet_header>;
+template class Basic_link_layer<1500,Packet_header>;
+template class Basic_link_layer<9000,Packet_header>;
@@ -2,56 +2,321 @@
 #include <unistd.h>
 #include <exception>
 #include <deque>
+#include <limits>
+#include <queue>
+#include <vector>
 
+#include "checksum.h"
+#include "metrics.h"
 #include "physical_layer.h"
+#include "reactor.h"
+#include "simulator.h"
+#include "spsc_ring.h"
+#include "timeval_operators.h"
 
 class Link_layer_exception: public exception
 {};
 
+// the default frame header. The header is a template parameter of the
+// link, and any struct with these fields will do: their types bound the
+// link's sequence numbers, sack bits and frame length
 struct Packet_header {
-	unsigned int checksum;
-	unsigned int seq;
+	unsigned int checksum; // 16-bit ones_complement_checksum or 32-bit crc32c
+	unsigned int seq; // ignored in ack-only frames
 	unsigned int ack;
-	unsigned int data_length;
+	// 0: an ack-only frame, never retransmitted
+	unsigned short data_length;
+	unsigned short flags; // Link_layer::ACK_NOW
+	// selective repeat: bit i set if frame ack+i is buffered at the receiver
+	unsigned int sack;
+	// frames from ack on the receiver has room for
+	unsigned int window;
+};
+
+// 10 bytes, for small MTUs: at most 256 sequence numbers, 16 sack bits
+// and 255 bytes of data. A crc32c is cut to its low 16 bits
+struct Compact_packet_header {
+	unsigned short checksum;
+	unsigned char seq;
+	unsigned char ack;
+	unsigned char data_length;
+	unsigned char flags;
+	unsigned short sack;
+	unsigned short window;
+};
+
+// a frame exactly MTU bytes long
+template <unsigned int MTU,class Header>
+struct Basic_packet {
+	Header header;
+	unsigned char data[MTU-sizeof(Header)];
+};
+
+template <unsigned int MTU,class Header>
+struct Basic_timed_packet {
+	timeval send_time; // next transmission is due
+	timeval first_send_time; // valid once transmissions > 0
+	timeval last_send_time;
+	unsigned int transmissions;
+	unsigned long backoffs; // the link's backoff count when last sent
+	unsigned long timer_order; // identifies its live Retransmit_timer
+	bool acked; // selective repeat: covered by a sack bit
+	Basic_packet<MTU,Header> packet;
+};
+
+// retransmission deadline of the queued frame with this seq; stale once
+// the frame's timer_order no longer matches
+struct Retransmit_timer {
+	timeval deadline;
+	unsigned int seq;
+	unsigned long order; // equal deadlines expire in the order they were set
+};
+
+// round-trip estimate of a link, in microseconds
+struct Rtt_estimate {
+	unsigned long srtt; // smoothed round-trip time; 0 until sampled
+	unsigned long rttvar; // round-trip time variation
+	unsigned long rto; // retransmission timeout, backoff included
+	unsigned long min_rtt; // shortest sample: the path with empty queues
+	unsigned long samples;
+	unsigned long backoffs; // times the timeout was doubled
 };
 
-struct Packet {
-	struct Packet_header header;
-	unsigned char data[Physical_layer_interface::MAXIMUM_BUFFER_LENGTH-
-	 sizeof(struct Packet_header)];
+// send window of a link, in frames
+struct Send_window {
+	unsigned int congestion; // congestion window
+	unsigned int threshold; // slow start below it, additive increase above
+	unsigned int receive; // last window the receiver advertised
+	unsigned int limit; // frames that may be unacknowledged now
 };
 
-struct Timed_packet {
-	timeval send_time;
-	struct Packet packet;
+// counts of a link since it was created
+struct Link_metrics {
+	unsigned long frames_sent; // data frames, first transmissions
+	unsigned long retransmissions;
+	unsigned long timeouts; // the oldest frame expired and the rto doubled
+	unsigned long acks_sent; // ack-only frames
+	unsigned long channel_busy; // sends the physical layer took only part of
+	unsigned long frames_received; // from the physical layer
+	unsigned long checksum_errors; // bad length or checksum: discarded
+	unsigned long frames_delivered; // to receive
+	// data frames that found receive_ring full: go-back-N discards them,
+	// selective repeat buffers them
+	unsigned long receive_full;
+	// data frames discarded: duplicates, outside the receive window, or
+	// go-back-N with no room
+	unsigned long discarded;
+	Histogram_snapshot rtt; // round-trip samples, in microseconds
+	// frames sent and unacknowledged as each new frame went out
+	Histogram_snapshot send_queue;
 };
 
-class Link_layer {
+inline bool operator>(const Retransmit_timer& t0,const Retransmit_timer& t1)
+{
+	return t0.deadline > t1.deadline
+	 || (t0.deadline == t1.deadline && t0.order > t1.order);
+}
+
+// A link over a Basic_physical_layer_interface<MTU>, with frames of
+// Header then data. Every buffer in it is sized at compile time, and frame
+// copies of up to FIXED_COPY_LENGTH bytes have a fixed length the compiler
+// can unroll. link_layer.cpp instantiates the configurations there is a
+// use for
+template <unsigned int MTU,class Header = Packet_header>
+class Basic_link_layer {
 public:
-	enum {MAXIMUM_DATA_LENGTH = 
-	 Physical_layer_interface::MAXIMUM_BUFFER_LENGTH-sizeof(Packet_header)};
+	typedef Basic_physical_layer_interface<MTU> Physical_layer_interface;
+	typedef Basic_packet<MTU,Header> Packet;
+	typedef Basic_timed_packet<MTU,Header> Timed_packet;
+
+	enum {MAXIMUM_DATA_LENGTH = MTU-sizeof(Header)};
     enum {HEADER_LENGTH =
-        sizeof(Packet_header)};
-	Link_layer(Physical_layer_interface* physical_layer_interface,
+        sizeof(Header)};
+    enum {SACK_BITS = 8*sizeof(Header::sack)};
+	// frames at most this long are always copied whole
+	enum {FIXED_COPY_LENGTH = 128};
+    enum {SEND_BATCH = 32}; // most frames handed to the PL per call
+    enum {DEFAULT_RECEIVE_DEPTH = 16};
+	enum Arq_mode {GO_BACK_N, SELECTIVE_REPEAT};
+	// bounds on the retransmission timeout, in microseconds
+	enum {MINIMUM_RTO = 1000};
+	enum {MAXIMUM_RTO = 60000000};
+	enum {INITIAL_WINDOW = 2};
+	// the congestion window aims to keep between DELAY_ALPHA and
+	// DELAY_BETA frames queued on the path
+	enum {DELAY_ALPHA = 2};
+	enum {DELAY_BETA = 4};
+	// round-trip growth, in microseconds, below which the path counts as
+	// empty; a real clock jitters by this much with nothing queued
+	enum {MINIMUM_QUEUE_DELAY = 250};
+	// a received data frame is acknowledged within ACK_DELAY
+	// microseconds, at once when ACK_EVERY are unacknowledged or it has
+	// ACK_NOW set, and sooner if a data frame carries the ack
+	enum {ACK_DELAY = 1000};
+	enum {ACK_EVERY = 2};
+	// flags: the sender has nothing more to send until this frame is
+	// acknowledged
+	enum {ACK_NOW = 1};
+
+	// timeout is the retransmission timeout, in microseconds, until the
+	// first round trip is measured. Runs on the physical layer's
+	// Simulator if it has one, else in real time: on one of reactor's
+	// threads if reactor is not NULL, else on a thread of its own
+	Basic_link_layer(Physical_layer_interface* physical_layer_interface,
 	 unsigned int num_sequence_numbers,
-	 unsigned int max_send_window_size,unsigned int timeout);
+	 unsigned int max_send_window_size,unsigned int timeout,
+	 Arq_mode arq_mode = GO_BACK_N,
+	 unsigned int receive_depth = DEFAULT_RECEIVE_DEPTH,
+	 Checksum_mode checksum_mode = ONES_COMPLEMENT,
+	 Reactor* reactor = NULL);
+	~Basic_link_layer();
 
+	// lock-free; returns 0 while the send ring is full
 	unsigned int send(unsigned char buffer[], unsigned int length);
 
+	// send frame i from buffer[i*MAXIMUM_DATA_LENGTH..], length[i] bytes
+	// long, in order until the send ring is full, with a single wakeup of
+	// the loop; return the number of frames accepted
+	unsigned int send_many(unsigned char buffer[],unsigned int length[],
+	 unsigned int num_frames);
+
+	// zero-copy send: fill up to MAXIMUM_DATA_LENGTH bytes at the address
+	// returned by send_loan, then send_commit them. send_loan returns NULL
+	// while the send ring is full
+	unsigned char* send_loan();
+	void send_commit(unsigned int length);
+
 	unsigned int receive(unsigned char buffer[]);
+
+	// copy up to max_frames delivered frames, frame i into
+	// buffer[i*MAXIMUM_DATA_LENGTH..] with its length in length[i];
+	// return the number of frames copied
+	unsigned int receive_many(unsigned char buffer[],unsigned int length[],
+	 unsigned int max_frames);
+
+	// zero-copy receive: borrow the oldest delivered frame, or NULL if
+	// there is none, and give it back with receive_release
+	const unsigned char* receive_loan(unsigned int& length);
+	void receive_release();
+
+	// lock-free: send would accept a frame, receive has one. Only the
+	// sending, or receiving, application thread can rely on the answer
+	// staying true; a listener may use it to pick whom to wake
+	bool can_send();
+	bool can_receive();
+
+	// listener is called from the protocol loop, with the link's lock
+	// held, after a pass that delivered frames to receive or freed send
+	// ring slots; it must not block or take the link's lock
+	void set_listener(void (*listener)(void*),void* listener_arg);
+
+	// current round-trip estimate and retransmission timeout
+	Rtt_estimate get_rtt_estimate();
+
+	// current send window; window_log, if set, is called with it and the
+	// time whenever it changes, from the protocol loop with the link's
+	// lock held
+	Send_window get_send_window();
+	void set_window_log(void (*window_log)(void*,const struct timeval&,
+	 const Send_window&),void* window_log_arg);
+
+	// lock-free; any thread may poll it while the link runs
+	Link_metrics get_metrics();
 private:
+	static_assert(sizeof(Header) < MTU && MTU-sizeof(Header)
+	 <= numeric_limits<decltype(Header::data_length)>::max(),
+	 "the header leaves no room for data, or cannot count it");
+	static_assert(sizeof(Packet) == MTU,
+	 "MTU is not a multiple of the header's alignment");
+
 	Physical_layer_interface* physical_layer_interface;
+	Arq_mode arq_mode;
+	Checksum_mode checksum_mode;
 	unsigned int num_sequence_numbers;
 	unsigned int max_send_window_size;
     unsigned int send_queue_size;
     
-    deque<Timed_packet> send_queue;
-    deque<Timed_packet>::iterator h;
+    // frames given a seq and not yet acked: send_ring slots, in ring
+    // order
+    deque<Timed_packet*> send_queue;
+    typename deque<Timed_packet*>::iterator h;
+
+    // header-only frame built whenever an ack is due with no data frame
+    // to carry it; sent once, never queued
+    Packet ack_packet;
+
+	// min-heap on deadline; one live entry per unacked frame
+	priority_queue<Retransmit_timer,vector<Retransmit_timer>,
+	 greater<Retransmit_timer> > timers;
+	unsigned long timer_order;
     
-    timeval timeval_timeout;
+	// RFC 6298 estimator, sampled only from frames sent once (Karn).
+	// rtt.rto is base_rto doubled once per backoff
+	Rtt_estimate rtt;
+	unsigned long base_rto;
+
+	// the window never exceeds max_send_window_size; it takes at least
+	// one frame so a closed receive window is probed
+	Send_window window;
+	unsigned int window_acked; // frames acked toward the next increase
+	void (*window_log)(void*,const struct timeval&,const Send_window&);
+	void* window_log_arg;
 	pthread_t thread;
+
+	// time source shared with the physical layer
+	Clock* clock;
+
+	// virtual-time mode: no thread, the loop runs as this timer, moved
+	// earlier whenever the link is woken
+	Simulator* simulator;
+	Simulator_timer event;
+
+	// reactor mode: likewise, in real time on a thread reactor shares
+	// with other links
+	Reactor* reactor;
+	Reactor_timer reactor_event;
+
+	// guards all protocol state below; never shared with another link.
+	// send and receive never take it: they only touch send_ring and
+	// receive_ring
+	pthread_mutex_t mutex;
+	bool running;
+
+	// application -> loop: frames written in place by the application.
+	// The loop sends and retransmits them from their slots and pops them
+	// once acked
+	Spsc_ring<Timed_packet> send_ring;
+	unsigned int ring_queued; // send_ring slots already in send_queue
+
+	// loop -> application: delivered frames
+	Spsc_ring<Packet> receive_ring;
+
+	// set by the loop before it blocks, so send only pays for a wakeup
+	// when the loop is asleep
+	std::atomic<bool> sleeping;
+
+	// set by the loop when receive_ring was full; receive then wakes it
+	std::atomic<bool> receive_stalled;
+
+	// eventfd the loop blocks on; written by send, the destructor and
+	// the physical layer listener
+	int wakeup_fd;
+
+	void (*listener)(void*);
+	void* listener_arg;
+	bool listener_pending; // this pass delivered or freed send slots
+
+	// an accepted data frame, or a reopened receive window, has not
+	// been acknowledged on the wire yet; an ack-only frame goes out at
+	// ack_deadline unless a data frame carries the ack first
+	bool ack_pending;
+	unsigned int ack_frames; // data frames the pending ack covers
+	timeval ack_deadline;
+
+	// the last transmission attempt found the channel busy
+	bool channel_busy;
     
-    unsigned int start, end, limit;
+    unsigned int start, end;
 
 	// seq for next packet added to send_queue
 	unsigned int next_send_seq;
@@ -59,18 +324,63 @@ private:
 	// seq of next packet expected from PL
 	unsigned int next_receive_seq;
 
-	// last ack received from PL
+	// last ack and sack received from PL
 	unsigned int last_receive_ack;
+	unsigned int last_receive_sack;
     unsigned int next_send_ack;
 
-	unsigned char receive_buffer[MAXIMUM_DATA_LENGTH];
-	unsigned int receive_buffer_length;
     unsigned char temp_buffer[MAXIMUM_DATA_LENGTH];
     unsigned int temp_buffer_length;
 
+	// selective repeat: frames received at or ahead of next_receive_seq,
+	// indexed by seq
+	vector<Packet> reorder_buffer;
+	vector<bool> reorder_valid;
+
+	// written by the loop with mutex held, read by get_metrics without it
+	struct {
+		Counter frames_sent,retransmissions,timeouts,acks_sent,channel_busy;
+		Counter frames_received,checksum_errors,frames_delivered;
+		Counter receive_full,discarded;
+		Histogram rtt,send_queue;
+	} metrics;
+
 	static void* loop(void* link_layer);
-	void process_received_packet(struct Packet p);
+	static void wakeup(void* link_layer);
+	static void run_event(void* link_layer);
+	void schedule_event(const timeval& time);
+	void process();
+	bool get_deadline(timeval& deadline);
+	bool has_work();
+	void wait_for_work();
+	void process_received_packet(const Packet& p);
+	bool deliver_buffered_packets();
+	bool push_received(const Packet& p);
+	unsigned int pop_received(unsigned char buffer[]);
+	void copy_data(unsigned char to[],const unsigned char from[],
+	 unsigned int length);
+	void notify_loop();
+	void notify_receive_space();
+	void accept_sent_packets();
+	unsigned int get_sack();
+	unsigned int get_advertised_window();
+	unsigned int set_checksum(Packet& p);
+	bool checksum_ok(const Packet& p);
+	Timed_packet* find_queued_packet(unsigned int seq);
+	void start_timer(Timed_packet& P);
+	void discard_stale_timers();
+	bool is_rtt_sample(const Timed_packet& P,const timeval& current);
+	void sample_rtt(const timeval& first_send_time);
+	void back_off(const timeval& current);
+	unsigned int get_path_backlog();
+	void open_window(unsigned int acked);
+	void update_window(const Send_window& before);
 	void remove_acked_packets();
 	void send_timed_out_packets();
-	void generate_ack_packet();
+	void delay_ack(bool now);
+	void send_ack_packet();
 };
+
+// the classic link: 100-byte frames, 32-bit header fields
+typedef Basic_link_layer<Physical_layer_interface::MAXIMUM_BUFFER_LENGTH>
+ Link_layer;
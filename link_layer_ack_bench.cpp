@@ -0,0 +1,87 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "bulk_transfer.h"
+
+using namespace std;
+
+// Acknowledgement benchmark: a bulk one-way transfer of full-size frames
+// a -> b on a Simulator, with go-back-N and selective repeat, at several
+// window sizes and drop rates. Counts what each side puts on the wire:
+// b sends nothing but acks, so its frames and bytes per frame delivered
+// are the control overhead of the transfer.
+
+const unsigned int NUM_SEQ = 64;
+const unsigned int TIMEOUT = 20000; // initial; the link adapts it
+const unsigned int DELAY = 1000; // microseconds each way
+const unsigned int BANDWIDTH = 1000000; // bits per second
+const unsigned int QUEUE_DEPTH = 64;
+
+void run(Link_layer::Arq_mode arq_mode,unsigned int max_win,double drop_rate,
+ unsigned int frames,unsigned int seed)
+{
+	Simulator simulator;
+	double drop[] = {drop_rate};
+	Impair impair(drop,1,NULL,0,DELAY,seed);
+	Physical_layer physical_layer(impair,impair,NULL,NULL,
+	 QUEUE_DEPTH,BANDWIDTH,&simulator);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,max_win,TIMEOUT,arq_mode,max_win);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,max_win,TIMEOUT,arq_mode,max_win);
+
+	Bulk_transfer<Link_layer> transfer(a_link_layer,b_link_layer,
+	 &simulator);
+	if (!transfer.run(frames)) {
+		cout << "simulation stalled" << endl;
+		exit(1);
+	}
+	double elapsed = transfer.get_seconds();
+
+	// the link should fall silent once the last ack is out
+	simulator.run_until(simulator.now()+usec_to_timeval(10*TIMEOUT));
+	double goodput = frames*Link_layer::MAXIMUM_DATA_LENGTH/elapsed;
+	Physical_layer_metrics a =
+	 physical_layer.get_a_interface()->get_metrics();
+	Physical_layer_metrics b =
+	 physical_layer.get_b_interface()->get_metrics();
+	unsigned long a_acks = a_link_layer.get_metrics().acks_sent;
+
+	cout << (arq_mode == Link_layer::GO_BACK_N ? "GBN" : "SR")
+	 << "\t" << max_win << "\t" << fixed << setprecision(2) << drop_rate
+	 << "\t" << setprecision(0) << goodput
+	 << "\t" << setprecision(2) << (double) a.frames_sent/frames
+	 << "\t" << (double) a_acks/frames
+	 << "\t" << (double) b.frames_sent/frames
+	 << "\t" << setprecision(1) << 100.0*b.bytes_sent/a.bytes_sent
+	 << "\t" << simulator.get_event_count() << endl;
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 3) {
+		cout << "Syntax: " << argv[0] << " frames seed" << endl;
+		exit(1);
+	}
+	unsigned int frames = atoi(argv[1]);
+	unsigned int seed = atoi(argv[2]);
+
+	cout << "delay " << DELAY << " us, bandwidth " << BANDWIDTH
+	 << " b/s; frames per frame delivered" << endl;
+	cout << "mode\twindow\tdrop\tB/s\ta sent\ta acks\tb sent\tb/a bytes %"
+	 << "\tevents" << endl;
+	Link_layer::Arq_mode modes[] = {Link_layer::GO_BACK_N,
+	 Link_layer::SELECTIVE_REPEAT};
+	unsigned int windows[] = {1,4,8,16};
+	double drop_rates[] = {0.0,0.01};
+	for (unsigned int m = 0; m < 2; m++) {
+		for (unsigned int w = 0; w < sizeof(windows)/sizeof(windows[0]); w++) {
+			for (unsigned int d = 0; d < sizeof(drop_rates)/sizeof(double); d++) {
+				run(modes[m],windows[w],drop_rates[d],frames,seed);
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "bulk_transfer.h"
+
+using namespace std;
+
+// ARQ benchmark: sends the same number of full-size frames a -> b over a
+// lossy 20 ms RTT, 1 Mbit/s Physical_layer with go-back-N and with
+// selective repeat, and reports goodput for each drop rate. The links run
+// on a Simulator with a fixed seed, so every run of the bench gives the
+// same figures, and each direction queues a whole window so that neither
+// mode is held back by the channel.
+
+const unsigned int NUM_SEQ = 16;
+const unsigned int MAX_WIN = 8;
+const unsigned int TIMEOUT = 50000;
+const unsigned int DELAY = 10000; // microseconds each way
+const unsigned int BANDWIDTH = 1000000; // bits per second
+const unsigned int QUEUE_DEPTH = 2*MAX_WIN;
+const unsigned int SEED = 1;
+
+double run(Link_layer::Arq_mode arq_mode,double drop_rate,unsigned int frames)
+{
+	Simulator simulator;
+	double drop[] = {drop_rate};
+	Impair impair(drop,1,NULL,0,DELAY,SEED);
+	Physical_layer physical_layer(impair,impair,NULL,NULL,
+	 QUEUE_DEPTH,BANDWIDTH,&simulator);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,arq_mode);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,arq_mode);
+
+	Bulk_transfer<Link_layer> transfer(a_link_layer,b_link_layer,
+	 &simulator);
+	if (!transfer.run(frames)) {
+		cout << "simulation stalled" << endl;
+		exit(1);
+	}
+	return frames*Link_layer::MAXIMUM_DATA_LENGTH/transfer.get_seconds();
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 2) {
+		cout << "Syntax: " << argv[0] << " frames" << endl;
+		exit(1);
+	}
+	unsigned int frames = atoi(argv[1]);
+	double drop_rates[] = {0.0,0.05,0.10,0.15,0.20};
+
+	cout << "drop\tgo-back-N B/s\tselective B/s" << endl;
+	for (unsigned int i = 0; i < sizeof(drop_rates)/sizeof(double); i++) {
+		double gbn = run(Link_layer::GO_BACK_N,drop_rates[i],frames);
+		double sr = run(Link_layer::SELECTIVE_REPEAT,drop_rates[i],frames);
+		cout << fixed << setprecision(2) << drop_rates[i] << "\t"
+		 << setprecision(0) << gbn << "\t" << sr << endl;
+	}
+
+	return 0;
+}
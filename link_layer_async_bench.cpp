@@ -0,0 +1,202 @@
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "async_link.h"
+#include "reactor.h"
+#include "timeval_operators.h"
+
+using namespace std;
+
+// Async benchmark: many application flows on a few threads. Builds
+// links/2 unimpaired link pairs on a shared Reactor and sends frames full
+// frames a -> b over every pair, each pair a sending and a receiving flow.
+// With poll, threads application threads each spin over a share of the
+// pairs, calling send and receive until they succeed, as send_n in
+// link_layer_test does. With async, every flow is an Async_task awaiting
+// async_send or async_receive, on an Async_scheduler of threads threads.
+// Reports the frame rate across all links, and the process's threads,
+// CPU time and context switches.
+
+const unsigned int NUM_SEQ = 64;
+const unsigned int MAX_WIN = 8;
+const unsigned int TIMEOUT = 20000; // initial; the link adapts it
+
+double seconds(struct timeval t)
+{
+	return t.tv_sec+t.tv_usec/1000000.0;
+}
+
+// a field of /proc/self/status, such as Threads
+long status(const char* field)
+{
+	ifstream in("/proc/self/status");
+	string line;
+	size_t n = strlen(field);
+	while (getline(in,line)) {
+		if (line.compare(0,n,field) == 0 && line[n] == ':') {
+			return atol(line.c_str()+n+1);
+		}
+	}
+	return -1;
+}
+
+struct Pair {
+	Physical_layer* physical_layer;
+	Link_layer* a;
+	Link_layer* b;
+	Async_link* async_a;
+	Async_link* async_b;
+};
+
+unsigned int frames;
+std::atomic<long> peak_threads;
+
+// poll -------------------------------------------------------------------
+
+struct Share {
+	vector<Pair>* links;
+	unsigned int first,step; // pairs first, first+step, ...
+	pthread_t thread;
+};
+
+void* poll_share(void* share0)
+{
+	Share* share = (Share*) share0;
+	vector<Pair>& links = *share->links;
+	unsigned char buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	memset(buffer,0,sizeof(buffer));
+	vector<unsigned int> sent(links.size()),received(links.size());
+	bool done = false;
+	while (!done) {
+		done = true;
+		for (unsigned int i = share->first; i < links.size();
+		 i += share->step) {
+			if (sent[i] < frames && links[i].a->send(buffer,
+			 Link_layer::MAXIMUM_DATA_LENGTH) > 0) {
+				sent[i]++;
+			}
+			if (links[i].b->receive(buffer) > 0) {
+				received[i]++;
+			}
+			done = done && received[i] == frames;
+		}
+	}
+	return NULL;
+}
+
+// async ------------------------------------------------------------------
+
+Async_task send_flow(Async_link* link)
+{
+	unsigned char buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	memset(buffer,0,sizeof(buffer));
+	for (unsigned int i = 0; i < frames; i++) {
+		co_await link->async_send(buffer,
+		 Link_layer::MAXIMUM_DATA_LENGTH);
+	}
+}
+
+Async_task receive_flow(Async_link* link)
+{
+	unsigned char buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	for (unsigned int i = 0; i < frames; i++) {
+		co_await link->async_receive(buffer);
+	}
+	long threads = status("Threads");
+	long peak = peak_threads.load();
+	while (threads > peak
+	 && !peak_threads.compare_exchange_weak(peak,threads)) {
+	}
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 5 || (strcmp(argv[3],"poll") != 0
+	 && strcmp(argv[3],"async") != 0)) {
+		cout << "Syntax: " << argv[0]
+		 << " links frames poll|async threads" << endl;
+		exit(1);
+	}
+	unsigned int pairs = atoi(argv[1])/2;
+	frames = atoi(argv[2]);
+	bool use_async = strcmp(argv[3],"async") == 0;
+	unsigned int threads = atoi(argv[4]);
+	if (threads == 0) {
+		cout << "threads must be at least 1" << endl;
+		exit(1);
+	}
+
+	Reactor reactor;
+	Async_scheduler* scheduler = use_async
+	 ? new Async_scheduler(threads) : NULL;
+	Impair impair;
+	Link_layer::Arq_mode arq = Link_layer::GO_BACK_N;
+	unsigned int depth = Link_layer::DEFAULT_RECEIVE_DEPTH;
+	vector<Pair> links(pairs);
+	for (unsigned int i = 0; i < pairs; i++) {
+		Pair& p = links[i];
+		Physical_layer* pl = new Physical_layer(impair,impair,NULL,NULL,
+		 MAX_WIN);
+		p.physical_layer = pl;
+		p.a = new Link_layer(pl->get_a_interface(),NUM_SEQ,MAX_WIN,
+		 TIMEOUT,arq,depth,ONES_COMPLEMENT,&reactor);
+		p.b = new Link_layer(pl->get_b_interface(),NUM_SEQ,MAX_WIN,
+		 TIMEOUT,arq,depth,ONES_COMPLEMENT,&reactor);
+		p.async_a = use_async ? new Async_link(p.a,scheduler) : NULL;
+		p.async_b = use_async ? new Async_link(p.b,scheduler) : NULL;
+	}
+	peak_threads.store(0);
+
+	struct rusage usage_start,usage_stop;
+	struct timeval start,stop;
+	getrusage(RUSAGE_SELF,&usage_start);
+	gettimeofday(&start,NULL);
+	if (use_async) {
+		for (unsigned int i = 0; i < pairs; i++) {
+			scheduler->spawn(receive_flow(links[i].async_b));
+			scheduler->spawn(send_flow(links[i].async_a));
+		}
+		scheduler->wait();
+	} else {
+		vector<Share> shares(threads);
+		for (unsigned int i = 0; i < threads; i++) {
+			shares[i].links = &links;
+			shares[i].first = i;
+			shares[i].step = threads;
+			pthread_create(&shares[i].thread,NULL,&poll_share,
+			 &shares[i]);
+		}
+		peak_threads.store(status("Threads"));
+		for (unsigned int i = 0; i < threads; i++) {
+			pthread_join(shares[i].thread,NULL);
+		}
+	}
+	gettimeofday(&stop,NULL);
+	getrusage(RUSAGE_SELF,&usage_stop);
+
+	for (unsigned int i = 0; i < pairs; i++) {
+		delete links[i].async_a;
+		delete links[i].async_b;
+		delete links[i].a;
+		delete links[i].b;
+		delete links[i].physical_layer;
+	}
+	delete scheduler;
+
+	double wall = seconds(stop-start);
+	double cpu = seconds(usage_stop.ru_utime-usage_start.ru_utime)
+	 +seconds(usage_stop.ru_stime-usage_start.ru_stime);
+	long switches = usage_stop.ru_nvcsw-usage_start.ru_nvcsw
+	 +usage_stop.ru_nivcsw-usage_start.ru_nivcsw;
+	cout << "mode\tflows\tthreads\tframes/s\tcpu s\tswitches" << endl;
+	cout << argv[3] << "\t" << 2*pairs << "\t" << peak_threads.load()
+	 << "\t" << fixed << setprecision(0) << (double) pairs*frames/wall
+	 << "\t" << setprecision(3) << cpu << "\t" << switches << endl;
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+#include "link_layer.h"
+
+using namespace std;
+
+// Batch benchmark: moves the same number of frames a -> b with
+// send_many/receive_many at growing batch sizes, and reports the median
+// time per frame of a full-batch call on each side. The median keeps time
+// the protocol threads steal from the caller on a busy core out of the
+// figures.
+
+const unsigned int NUM_SEQ = 1024;
+const unsigned int MAX_WIN = 256;
+const unsigned int TIMEOUT = 100000;
+const unsigned int MAX_BATCH = 64;
+
+double now_ns()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec*1e9+t.tv_nsec;
+}
+
+double median(vector<double>& samples)
+{
+	if (samples.empty()) {
+		return 0;
+	}
+	sort(samples.begin(),samples.end());
+	return samples[samples.size()/2];
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 3) {
+		cout << "Syntax: " << argv[0] << " frames payload_length" << endl;
+		exit(1);
+	}
+	unsigned int frames = atoi(argv[1]);
+	unsigned int length = atoi(argv[2]);
+
+	Impair impair(NULL,0,NULL,0,0);
+	Physical_layer physical_layer(impair,impair,NULL,NULL);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::GO_BACK_N,2*MAX_WIN);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::GO_BACK_N,2*MAX_WIN);
+
+	unsigned char* send_buffer =
+	 new unsigned char[MAX_BATCH*Link_layer::MAXIMUM_DATA_LENGTH]();
+	unsigned char* receive_buffer =
+	 new unsigned char[MAX_BATCH*Link_layer::MAXIMUM_DATA_LENGTH];
+	unsigned int send_length[MAX_BATCH];
+	unsigned int receive_length[MAX_BATCH];
+	for (unsigned int i = 0; i < MAX_BATCH; i++) {
+		send_length[i] = length;
+	}
+
+	cout << "batch\tsend ns/frame\treceive ns/frame" << endl;
+	for (unsigned int batch = 1; batch <= MAX_BATCH; batch *= 2) {
+		vector<double> send_time,receive_time;
+		unsigned int sent = 0,received = 0;
+
+		while (received < frames) {
+			if (sent < frames) {
+				unsigned int n = frames-sent < batch ? frames-sent : batch;
+				double start = now_ns();
+				n = a_link_layer.send_many(send_buffer,send_length,n);
+				double stop = now_ns();
+				if (n == batch) {
+					send_time.push_back((stop-start)/n);
+				}
+				sent += n;
+			}
+			double start = now_ns();
+			unsigned int n = b_link_layer.receive_many(receive_buffer,
+			 receive_length,batch);
+			double stop = now_ns();
+			if (n == batch) {
+				receive_time.push_back((stop-start)/n);
+			}
+			received += n;
+		}
+		cout << batch << fixed << setprecision(1)
+		 << "\t" << median(send_time)
+		 << "\t" << median(receive_time) << endl;
+	}
+
+	delete[] send_buffer;
+	delete[] receive_buffer;
+	return 0;
+}
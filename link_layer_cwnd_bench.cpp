@@ -0,0 +1,115 @@
+#include <iostream>
+#include <iomanip>
+#include <string.h>
+#include <stdlib.h>
+
+#include "bulk_transfer.h"
+
+using namespace std;
+
+// Congestion window benchmark: sends full-size frames a -> b with
+// selective repeat on a Simulator, over channels of different loss,
+// delay and bandwidth, all with a queue deep enough for the largest
+// window. Reports the goodput against the best the bandwidth and largest
+// window allow, the frames a put on the wire per frame delivered, and
+// the window a settled on. With "trace", also prints every change of a's
+// window.
+
+const unsigned int NUM_SEQ = 64;
+const unsigned int MAX_WIN = 32;
+const unsigned int TIMEOUT = 20000; // initial; the link adapts it
+const unsigned int QUEUE_DEPTH = 64;
+
+struct Profile {
+	double drop;
+	unsigned int delay; // microseconds each way
+	unsigned int bandwidth; // bits per second
+};
+
+const Profile profiles[] = {
+	{0,1000,1000000},
+	{0,20000,1000000},
+	{0,20000,10000000},
+	{0.01,1000,1000000},
+	{0.01,20000,1000000},
+	{0.01,20000,10000000},
+	{0.05,5000,1000000},
+	{0.05,50000,1000000},
+	{0.1,5000,1000000}
+};
+
+void window_log(void* arg,const struct timeval& time,
+ const Send_window& window)
+{
+	cout << "\t" << fixed << setprecision(3)
+	 << time.tv_sec+time.tv_usec/1000000.0
+	 << "\tcwnd " << window.congestion << "\tssthresh " << window.threshold
+	 << "\trwnd " << window.receive << "\tlimit " << window.limit << endl;
+}
+
+void run(const Profile& profile,unsigned int frames,unsigned int seed,
+ bool trace)
+{
+	Simulator simulator;
+	double drop[] = {profile.drop};
+	Impair impair(drop,1,NULL,0,profile.delay,seed);
+	Physical_layer physical_layer(impair,impair,NULL,NULL,
+	 QUEUE_DEPTH,profile.bandwidth,&simulator);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::SELECTIVE_REPEAT,MAX_WIN);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::SELECTIVE_REPEAT,MAX_WIN);
+	if (trace) {
+		a_link_layer.set_window_log(&window_log,NULL);
+	}
+
+	Bulk_transfer<Link_layer> transfer(a_link_layer,b_link_layer,
+	 &simulator);
+	if (!transfer.run(frames)) {
+		cout << "simulation stalled" << endl;
+		exit(1);
+	}
+	double elapsed = transfer.get_seconds();
+
+	// a full frame out, a header-only ack back
+	double frame_time = 8.0*Physical_layer_interface::MAXIMUM_BUFFER_LENGTH
+	 /profile.bandwidth;
+	double rtt = 2*profile.delay/1000000.0+frame_time
+	 +8.0*Link_layer::HEADER_LENGTH/profile.bandwidth;
+	double best = MAX_WIN/rtt < 1/frame_time ? MAX_WIN/rtt : 1/frame_time;
+	best *= Link_layer::MAXIMUM_DATA_LENGTH;
+	double goodput = frames*Link_layer::MAXIMUM_DATA_LENGTH/elapsed;
+	// put on the wire by a
+	unsigned long a_frames =
+	 physical_layer.get_a_interface()->get_metrics().frames_sent;
+
+	Send_window window = a_link_layer.get_send_window();
+	cout << fixed << setprecision(2) << profile.drop
+	 << "\t" << setprecision(1) << profile.delay/1000.0
+	 << "\t" << profile.bandwidth/1000000.0
+	 << "\t" << setprecision(0) << best << "\t" << goodput
+	 << "\t" << setprecision(1) << 100*goodput/best
+	 << "\t" << setprecision(2) << (double) a_frames/frames
+	 << "\t" << window.congestion << "\t" << window.threshold << endl;
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 3 && !(argc == 4 && strcmp(argv[3],"trace") == 0)) {
+		cout << "Syntax: " << argv[0] << " frames seed [trace]" << endl;
+		exit(1);
+	}
+	unsigned int frames = atoi(argv[1]);
+	unsigned int seed = atoi(argv[2]);
+	bool trace = argc == 4;
+
+	cout << "largest window " << MAX_WIN << ", queue depth " << QUEUE_DEPTH
+	 << endl;
+	cout << "drop\tdelay ms\tMb/s\tbest B/s\tB/s\t% best\tsent/frame"
+	 << "\tcwnd\tssthresh" << endl;
+	for (unsigned int i = 0; i < sizeof(profiles)/sizeof(profiles[0]); i++) {
+		run(profiles[i],frames,seed,trace);
+	}
+
+	return 0;
+}
@@ -0,0 +1,184 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bulk_transfer.h"
+
+using namespace std;
+
+// Impairment benchmark. First the cost of Impair's decisions, in
+// nanoseconds each, beside the rand_r and floating-point divide it used
+// to make per decision. Then a bulk transfer a -> b of full frames on a
+// Simulator under each kind of impairment at about the same average
+// loss, with go-back-N and selective repeat: independent loss, burst
+// loss, jitter, reordering and duplication.
+
+const unsigned int NUM_SEQ = 64;
+const unsigned int MAX_WIN = 16;
+const unsigned int TIMEOUT = 20000; // initial; the link adapts it
+const unsigned int DELAY = 1000; // microseconds each way
+const unsigned int BANDWIDTH = 1000000; // bits per second
+const unsigned int QUEUE_DEPTH = 64;
+
+double elapsed_ns(const struct timeval& start,unsigned long n)
+{
+	struct timeval stop;
+	gettimeofday(&stop,NULL);
+	return seconds(stop-start)*1e9/n;
+}
+
+// the decision Impair used to make: rand_r scaled by a divide
+bool legacy_drop(unsigned int* state,double p)
+{
+	int r = rand_r(state);
+	return ((double) r / (double) RAND_MAX) < p;
+}
+
+void decision_costs(unsigned long n)
+{
+	double drop[] = {0.01};
+	double corrupt[] = {0.01};
+	Impair impair(drop,1,corrupt,1,DELAY);
+	Burst_loss burst_loss = {0.01,0.3,0.0,0.5};
+	unsigned char frame[Link_layer::MAXIMUM_DATA_LENGTH];
+	memset(frame,0,sizeof(frame));
+	unsigned long hits = 0;
+	struct timeval start;
+
+	cout << "decision\tns" << endl;
+
+	unsigned int state = 1;
+	gettimeofday(&start,NULL);
+	for (unsigned long i = 0; i < n; i++) {
+		hits += legacy_drop(&state,0.01);
+	}
+	cout << "rand_r drop\t" << fixed << setprecision(2)
+	 << elapsed_ns(start,n) << endl;
+
+	gettimeofday(&start,NULL);
+	for (unsigned long i = 0; i < n; i++) {
+		hits += impair.drop_packet();
+	}
+	cout << "drop_packet\t" << elapsed_ns(start,n) << endl;
+
+	impair.set_burst_loss(burst_loss);
+	gettimeofday(&start,NULL);
+	for (unsigned long i = 0; i < n; i++) {
+		hits += impair.drop_packet();
+	}
+	cout << "drop_packet burst\t" << elapsed_ns(start,n) << endl;
+
+	gettimeofday(&start,NULL);
+	for (unsigned long i = 0; i < n; i++) {
+		hits += impair.corrupt_packet(frame,sizeof(frame));
+	}
+	cout << "corrupt_packet\t" << elapsed_ns(start,n) << endl;
+
+	impair.set_jitter(Impair::JITTER_PARETO,1000);
+	gettimeofday(&start,NULL);
+	for (unsigned long i = 0; i < n; i++) {
+		hits += impair.get_delay().tv_usec;
+	}
+	cout << "get_delay jitter\t" << elapsed_ns(start,n) << endl;
+
+	impair.set_reorder(0.01);
+	impair.set_duplicate(0.01);
+	gettimeofday(&start,NULL);
+	for (unsigned long i = 0; i < n; i++) {
+		hits += impair.corrupt_packet(frame,sizeof(frame));
+		hits += impair.drop_packet();
+		hits += impair.get_delay().tv_usec;
+		hits += impair.reorder_packet();
+		hits += impair.duplicate_packet();
+		impair.next();
+	}
+	cout << "all of them\t" << elapsed_ns(start,n) << endl;
+
+	// keep the loops from being optimized away
+	if (hits == 0) {
+		cout << endl;
+	}
+}
+
+struct Scenario {
+	const char* name;
+	double drop;
+	Burst_loss burst_loss; // used if good_to_bad > 0
+	Impair::Jitter jitter;
+	unsigned int jitter_mean;
+	double reorder;
+	double duplicate;
+};
+
+const Scenario SCENARIOS[] = {
+	{"clean",0.0,{0,0,0,0},Impair::JITTER_NONE,0,0.0,0.0},
+	{"2% loss",0.02,{0,0,0,0},Impair::JITTER_NONE,0,0.0,0.0},
+	// 2% on average, in bursts of 4 frames at a time
+	{"2% burst loss",0.0,{0.0051,0.25,0.0,1.0},Impair::JITTER_NONE,0,
+	 0.0,0.0},
+	{"uniform jitter",0.0,{0,0,0,0},Impair::JITTER_UNIFORM,1000,0.0,0.0},
+	{"pareto jitter",0.0,{0,0,0,0},Impair::JITTER_PARETO,1000,0.0,0.0},
+	{"2% reordering",0.0,{0,0,0,0},Impair::JITTER_NONE,0,0.02,0.0},
+	{"2% duplication",0.0,{0,0,0,0},Impair::JITTER_NONE,0,0.0,0.02},
+};
+const unsigned int NUM_SCENARIOS = sizeof(SCENARIOS)/sizeof(SCENARIOS[0]);
+
+Impair make_impair(const Scenario& scenario,unsigned int seed)
+{
+	double drop[] = {scenario.drop};
+	Impair impair(drop,1,NULL,0,DELAY,seed);
+	if (scenario.burst_loss.good_to_bad > 0) {
+		impair.set_burst_loss(scenario.burst_loss);
+	}
+	impair.set_jitter(scenario.jitter,scenario.jitter_mean);
+	impair.set_reorder(scenario.reorder);
+	impair.set_duplicate(scenario.duplicate);
+	return impair;
+}
+
+// frames per second delivered, or 0 if the simulation stalls
+double goodput(const Scenario& scenario,Link_layer::Arq_mode arq_mode,
+ unsigned int frames,unsigned int seed)
+{
+	Simulator simulator;
+	Impair a_impair = make_impair(scenario,seed);
+	Impair b_impair = make_impair(scenario,seed+1);
+	Physical_layer physical_layer(a_impair,b_impair,NULL,NULL,
+	 QUEUE_DEPTH,BANDWIDTH,&simulator);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,arq_mode,MAX_WIN);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,arq_mode,MAX_WIN);
+
+	Bulk_transfer<Link_layer> transfer(a_link_layer,b_link_layer,
+	 &simulator);
+	if (!transfer.run(frames)) {
+		return 0;
+	}
+	return frames/transfer.get_seconds();
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 4) {
+		cout << "Syntax: " << argv[0] << " decisions frames seed" << endl;
+		exit(1);
+	}
+	unsigned long decisions = atol(argv[1]);
+	unsigned int frames = atoi(argv[2]);
+	unsigned int seed = atoi(argv[3]);
+
+	decision_costs(decisions);
+
+	cout << endl << "simulated: delay " << DELAY << " us, bandwidth "
+	 << BANDWIDTH << " b/s, window " << MAX_WIN << endl;
+	cout << "impairment\tgbn frames/s\tsr frames/s" << endl;
+	for (unsigned int i = 0; i < NUM_SCENARIOS; i++) {
+		cout << SCENARIOS[i].name << "\t" << setprecision(1)
+		 << goodput(SCENARIOS[i],Link_layer::GO_BACK_N,frames,seed) << "\t"
+		 << goodput(SCENARIOS[i],Link_layer::SELECTIVE_REPEAT,frames,seed)
+		 << endl;
+	}
+	return 0;
+}
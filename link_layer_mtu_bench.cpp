@@ -0,0 +1,117 @@
+#include <iostream>
+#include <iomanip>
+#include <math.h>
+#include <stdlib.h>
+
+#include "bulk_transfer.h"
+
+using namespace std;
+
+// MTU benchmark: four frame formats in one binary, side by side - tiny
+// 32-byte frames with Compact_packet_header, the classic 100 bytes, and
+// 1500 and jumbo 9000 bytes with the full header. Each moves the same
+// number of bytes a -> b with full frames: on a Simulator at a fixed
+// bandwidth and delay, clean and at two bit error rates (a frame is
+// dropped if any of its bits is hit, so big frames are lost more often),
+// then in real time over an unimpaired link, where the cost per frame
+// decides.
+
+const unsigned int NUM_SEQ = 256;
+const unsigned int MAX_WIN = 128;
+const unsigned int TIMEOUT = 20000; // initial; the link adapts it
+const unsigned int DELAY = 1000; // microseconds each way
+const unsigned int BANDWIDTH = 10000000; // bits per second
+const double BIT_ERROR_RATES[] = {0.0,1e-6,1e-5};
+const unsigned int NUM_RATES = sizeof(BIT_ERROR_RATES)/sizeof(double);
+
+// bytes per second delivered on the simulated path, or 0 if it stalls
+template <unsigned int MTU,class Header>
+double simulated_goodput(double bit_error_rate,unsigned long total,
+ unsigned int seed)
+{
+	typedef Basic_link_layer<MTU,Header> Link;
+
+	// a sends full frames, b only acks
+	Simulator simulator;
+	double a_drop[] = {1-pow(1-bit_error_rate,8.0*MTU)};
+	double b_drop[] = {1-pow(1-bit_error_rate,8.0*Link::HEADER_LENGTH)};
+	Impair a_impair(a_drop,1,NULL,0,DELAY,seed);
+	Impair b_impair(b_drop,1,NULL,0,DELAY,seed+1);
+	Basic_physical_layer<MTU> physical_layer(a_impair,b_impair,NULL,NULL,
+	 MAX_WIN,BANDWIDTH,&simulator);
+	Link a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link::GO_BACK_N,MAX_WIN);
+	Link b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link::GO_BACK_N,MAX_WIN);
+
+	unsigned int frames = (total+Link::MAXIMUM_DATA_LENGTH-1)
+	 /Link::MAXIMUM_DATA_LENGTH;
+	Bulk_transfer<Link> transfer(a_link_layer,b_link_layer,&simulator);
+	if (!transfer.run(frames)) {
+		return 0;
+	}
+	return (double) frames*Link::MAXIMUM_DATA_LENGTH/transfer.get_seconds();
+}
+
+// frames per second through an unimpaired link in real time
+template <unsigned int MTU,class Header>
+double real_frame_rate(unsigned long total)
+{
+	typedef Basic_link_layer<MTU,Header> Link;
+
+	Impair impair(NULL,0,NULL,0,0);
+	Basic_physical_layer<MTU> physical_layer(impair,impair,NULL,NULL,
+	 MAX_WIN);
+	Link a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link::GO_BACK_N,MAX_WIN);
+	Link b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link::GO_BACK_N,MAX_WIN);
+
+	unsigned int frames = (total+Link::MAXIMUM_DATA_LENGTH-1)
+	 /Link::MAXIMUM_DATA_LENGTH;
+	Bulk_transfer<Link> transfer(a_link_layer,b_link_layer,NULL);
+	transfer.run(frames);
+	return frames/transfer.get_wall_seconds();
+}
+
+template <unsigned int MTU,class Header>
+void run(unsigned long total,unsigned int seed)
+{
+	typedef Basic_link_layer<MTU,Header> Link;
+
+	cout << MTU << "\t" << Link::HEADER_LENGTH
+	 << "\t" << fixed << setprecision(1)
+	 << 100.0*Link::HEADER_LENGTH/MTU << setprecision(0);
+	for (unsigned int i = 0; i < NUM_RATES; i++) {
+		cout << "\t" << simulated_goodput<MTU,Header>(BIT_ERROR_RATES[i],
+		 total,seed);
+	}
+	double rate = real_frame_rate<MTU,Header>(total);
+	cout << "\t" << rate << "\t" << setprecision(2)
+	 << rate*Link::MAXIMUM_DATA_LENGTH/1000000 << endl;
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 3) {
+		cout << "Syntax: " << argv[0] << " megabytes seed" << endl;
+		exit(1);
+	}
+	unsigned long total = atof(argv[1])*1000000;
+	unsigned int seed = atoi(argv[2]);
+
+	cout << "simulated: delay " << DELAY << " us, bandwidth " << BANDWIDTH
+	 << " b/s, go-back-N window " << MAX_WIN << endl;
+	cout << "MTU\theader\theader %";
+	for (unsigned int i = 0; i < NUM_RATES; i++) {
+		cout << "\tB/s ber " << BIT_ERROR_RATES[i];
+	}
+	cout << "\treal frames/s\treal MB/s" << endl;
+
+	run<32,Compact_packet_header>(total,seed);
+	run<100,Packet_header>(total,seed);
+	run<1500,Packet_header>(total,seed);
+	run<9000,Packet_header>(total,seed);
+
+	return 0;
+}
@@ -0,0 +1,144 @@
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "link_layer.h"
+#include "reactor.h"
+#include "timeval_operators.h"
+
+using namespace std;
+
+// Reactor benchmark: many links in one process. Builds links/2 unimpaired
+// link pairs in real time, each running its protocol loop either on a
+// thread of its own or on a shared Reactor, and sends frames full frames
+// a -> b over every pair, the application round-robin over the pairs on
+// the main thread. Reports the frame rate across all links, and what
+// hosting them cost the process: its threads, resident memory, CPU time
+// and context switches.
+
+const unsigned int NUM_SEQ = 64;
+const unsigned int MAX_WIN = 8;
+const unsigned int TIMEOUT = 20000; // initial; the link adapts it
+
+double seconds(struct timeval t)
+{
+	return t.tv_sec+t.tv_usec/1000000.0;
+}
+
+// a field of /proc/self/status, such as VmRSS in kB
+long status(const char* field)
+{
+	ifstream in("/proc/self/status");
+	string line;
+	size_t n = strlen(field);
+	while (getline(in,line)) {
+		if (line.compare(0,n,field) == 0 && line[n] == ':') {
+			return atol(line.c_str()+n+1);
+		}
+	}
+	return -1;
+}
+
+struct Pair {
+	Physical_layer* physical_layer;
+	Link_layer* a;
+	Link_layer* b;
+	unsigned int sent;
+	unsigned int received;
+};
+
+int main(int argc,char* argv[])
+{
+	if (argc < 4 || argc > 5 || (strcmp(argv[3],"thread") != 0
+	 && strcmp(argv[3],"reactor") != 0)) {
+		cout << "Syntax: " << argv[0]
+		 << " links frames thread|reactor [reactor_threads]" << endl;
+		exit(1);
+	}
+	unsigned int pairs = atoi(argv[1])/2;
+	unsigned int frames = atoi(argv[2]);
+	bool use_reactor = strcmp(argv[3],"reactor") == 0;
+	unsigned int reactor_threads = argc == 5 ? atoi(argv[4]) : 0;
+
+	Reactor* reactor = use_reactor ? new Reactor(reactor_threads) : NULL;
+	Impair impair;
+	Link_layer::Arq_mode arq = Link_layer::GO_BACK_N;
+	unsigned int depth = Link_layer::DEFAULT_RECEIVE_DEPTH;
+	vector<Pair> links(pairs);
+	unsigned int built = 0;
+	try {
+		for (; built < pairs; built++) {
+			Pair& p = links[built];
+			Physical_layer* pl = new Physical_layer(impair,impair,
+			 NULL,NULL,MAX_WIN);
+			p.physical_layer = pl;
+			p.a = new Link_layer(pl->get_a_interface(),NUM_SEQ,
+			 MAX_WIN,TIMEOUT,arq,depth,ONES_COMPLEMENT,reactor);
+			p.b = new Link_layer(pl->get_b_interface(),NUM_SEQ,
+			 MAX_WIN,TIMEOUT,arq,depth,ONES_COMPLEMENT,reactor);
+			p.sent = p.received = 0;
+		}
+	} catch (Link_layer_exception&) {
+		// out of threads or descriptors; half a pair is not worth
+		// undoing
+		cout << "could only build " << 2*built << " links" << endl;
+		exit(1);
+	}
+	long threads = status("Threads");
+
+	unsigned char send_buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	unsigned char receive_buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	memset(send_buffer,0,sizeof(send_buffer));
+	unsigned long remaining = (unsigned long) pairs*frames;
+
+	struct rusage usage_start,usage_stop;
+	struct timeval start,stop;
+	getrusage(RUSAGE_SELF,&usage_start);
+	gettimeofday(&start,NULL);
+	while (remaining > 0) {
+		bool idle = true;
+		for (unsigned int i = 0; i < pairs; i++) {
+			Pair& p = links[i];
+			while (p.sent < frames && p.a->send(send_buffer,
+			 Link_layer::MAXIMUM_DATA_LENGTH) > 0) {
+				p.sent++;
+				idle = false;
+			}
+			while (p.b->receive(receive_buffer) > 0) {
+				p.received++;
+				remaining--;
+				idle = false;
+			}
+		}
+		if (idle) {
+			usleep(10);
+		}
+	}
+	gettimeofday(&stop,NULL);
+	getrusage(RUSAGE_SELF,&usage_stop);
+	long rss = status("VmRSS");
+
+	for (unsigned int i = 0; i < pairs; i++) {
+		delete links[i].a;
+		delete links[i].b;
+		delete links[i].physical_layer;
+	}
+	delete reactor;
+
+	double wall = seconds(stop-start);
+	double cpu = seconds(usage_stop.ru_utime-usage_start.ru_utime)
+	 +seconds(usage_stop.ru_stime-usage_start.ru_stime);
+	long switches = usage_stop.ru_nvcsw-usage_start.ru_nvcsw
+	 +usage_stop.ru_nivcsw-usage_start.ru_nivcsw;
+	cout << "mode\tlinks\tthreads\trss kB\tframes/s\tcpu s\tswitches"
+	 << endl;
+	cout << argv[3] << "\t" << 2*pairs << "\t" << threads << "\t" << rss
+	 << "\t" << fixed << setprecision(0) << (double) pairs*frames/wall
+	 << "\t" << setprecision(3) << cpu << "\t" << switches << endl;
+	return 0;
+}
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "bulk_transfer.h"
+#include "replay.h"
+
+using namespace std;
+
+// Replay benchmark: a captured trace against a range of link settings. A
+// bulk transfer a -> b of full frames runs on a Simulator for each ARQ
+// mode and window size, with data frames drawing their fates from the
+// replay file from its first event and acks from its middle. Runs depend
+// only on the file and the arguments, so settings can be compared on the
+// same day's capture. Reports the time the file took to open, then each
+// setting's goodput, retransmissions per frame delivered and the host
+// time the run took. Make replay files with csv_to_replay.
+
+const unsigned int NUM_SEQ = 256;
+const unsigned int TIMEOUT = 20000; // initial; the link adapts it
+const unsigned int BANDWIDTH = 10000000; // bits per second
+const unsigned int WINDOWS[] = {4,8,16,32};
+const unsigned int NUM_WINDOWS = sizeof(WINDOWS)/sizeof(WINDOWS[0]);
+
+void run(const Replay& replay,Link_layer::Arq_mode arq_mode,
+ unsigned int window,unsigned int frames)
+{
+	Simulator simulator;
+	Impair a_impair;
+	Impair b_impair;
+	a_impair.set_replay(&replay);
+	b_impair.set_replay(&replay,replay.get_length()/2);
+	Physical_layer physical_layer(a_impair,b_impair,NULL,NULL,
+	 window,BANDWIDTH,&simulator);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,window,TIMEOUT,arq_mode,window);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,window,TIMEOUT,arq_mode,window);
+
+	Bulk_transfer<Link_layer> transfer(a_link_layer,b_link_layer,
+	 &simulator);
+	bool completed = transfer.run(frames);
+	double link_seconds = transfer.get_seconds();
+	Link_metrics metrics = a_link_layer.get_metrics();
+
+	cout << (arq_mode == Link_layer::GO_BACK_N ? "gbn" : "sr") << "\t"
+	 << window << "\t";
+	if (completed && link_seconds > 0) {
+		cout << setprecision(1) << frames/link_seconds << "\t"
+		 << setprecision(3) << (double) metrics.retransmissions/frames;
+	} else {
+		cout << "stalled\t-";
+	}
+	cout << "\t" << transfer.get_wall_seconds() << endl;
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 3) {
+		cout << "Syntax: " << argv[0] << " replay_file frames" << endl;
+		exit(1);
+	}
+	unsigned int frames = atoi(argv[2]);
+
+	struct timeval start,stop;
+	gettimeofday(&start,NULL);
+	Replay* replay;
+	try {
+		replay = new Replay(argv[1]);
+	} catch (Replay_exception&) {
+		cerr << argv[1] << " is not a version " << REPLAY_VERSION
+		 << " replay file" << endl;
+		exit(1);
+	}
+	gettimeofday(&stop,NULL);
+	cout << replay->get_length() << " events opened in " << fixed
+	 << setprecision(6) << seconds(stop-start) << " s" << endl;
+
+	cout << "mode\twindow\tframes/s\tretransmissions/frame\twall s" << endl;
+	for (unsigned int i = 0; i < NUM_WINDOWS; i++) {
+		run(*replay,Link_layer::GO_BACK_N,WINDOWS[i],frames);
+		run(*replay,Link_layer::SELECTIVE_REPEAT,WINDOWS[i],frames);
+	}
+	delete replay;
+	return 0;
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "bulk_transfer.h"
+
+using namespace std;
+
+// Retransmission timeout benchmark: sends full-size frames a -> b with
+// selective repeat over a lossy 1 Mbit/s Physical_layer on a Simulator,
+// at propagation delays from 1 ms to 200 ms, always starting from the
+// same timeout. Reports the goodput against the best the window and
+// bandwidth allow, the frames a put on the wire per frame delivered
+// (spurious retransmissions push it up), and the link's final round-trip
+// estimate.
+
+const unsigned int NUM_SEQ = 64;
+const unsigned int MAX_WIN = 32;
+const unsigned int TIMEOUT = 20000; // initial; the link adapts it
+const unsigned int BANDWIDTH = 1000000; // bits per second
+const unsigned int QUEUE_DEPTH = 64;
+const double DROP_RATE = 0.01;
+
+void run(unsigned int delay,unsigned int frames,unsigned int seed)
+{
+	Simulator simulator;
+	double drop[] = {DROP_RATE};
+	Impair impair(drop,1,NULL,0,delay,seed);
+	Physical_layer physical_layer(impair,impair,NULL,NULL,
+	 QUEUE_DEPTH,BANDWIDTH,&simulator);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::SELECTIVE_REPEAT,MAX_WIN);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::SELECTIVE_REPEAT,MAX_WIN);
+
+	Bulk_transfer<Link_layer> transfer(a_link_layer,b_link_layer,
+	 &simulator);
+	if (!transfer.run(frames)) {
+		cout << "simulation stalled" << endl;
+		exit(1);
+	}
+	double elapsed = transfer.get_seconds();
+
+	// a full frame out, a header-only ack back
+	double frame_time = 8.0*Physical_layer_interface::MAXIMUM_BUFFER_LENGTH
+	 /BANDWIDTH;
+	double rtt = 2*delay/1000000.0+frame_time
+	 +8.0*Link_layer::HEADER_LENGTH/BANDWIDTH;
+	double best = MAX_WIN/rtt < 1/frame_time ? MAX_WIN/rtt : 1/frame_time;
+	best *= Link_layer::MAXIMUM_DATA_LENGTH;
+	double goodput = frames*Link_layer::MAXIMUM_DATA_LENGTH/elapsed;
+	// put on the wire by a
+	unsigned long a_frames =
+	 physical_layer.get_a_interface()->get_metrics().frames_sent;
+
+	Rtt_estimate estimate = a_link_layer.get_rtt_estimate();
+	cout << fixed << setprecision(1) << delay/1000.0
+	 << "\t" << setprecision(0) << best
+	 << "\t" << goodput << "\t" << setprecision(1) << 100*goodput/best
+	 << "\t" << setprecision(2) << (double) a_frames/frames
+	 << "\t" << setprecision(1) << estimate.srtt/1000.0
+	 << "\t" << estimate.rto/1000.0 << endl;
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 3) {
+		cout << "Syntax: " << argv[0] << " frames seed" << endl;
+		exit(1);
+	}
+	unsigned int frames = atoi(argv[1]);
+	unsigned int seed = atoi(argv[2]);
+
+	cout << "initial timeout " << TIMEOUT/1000.0 << " ms, bandwidth "
+	 << BANDWIDTH << " b/s, drop rate " << DROP_RATE << endl;
+	cout << "delay ms\tbest B/s\tB/s\t% best\tsent/frame\tsrtt ms\trto ms"
+	 << endl;
+	unsigned int delays[] = {1000,5000,20000,50000,200000};
+	for (unsigned int i = 0; i < sizeof(delays)/sizeof(delays[0]); i++) {
+		run(delays[i],frames,seed);
+	}
+
+	return 0;
+}
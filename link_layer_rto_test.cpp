@@ -0,0 +1,83 @@
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+#include "link_layer.h"
+#include "simulator.h"
+#include "timeval_operators.h"
+
+using namespace std;
+
+// RTO test: a clean path whose frames take long on the wire, so that slow
+// start queues them past the initial timeout. The estimator must learn the
+// real round trip from the spurious retransmissions' acks instead of only
+// from the frames that beat the timer; the link then runs near capacity,
+// sending each frame about once.
+
+const unsigned int MTU = 1500;
+const unsigned int NUM_SEQ = 256;
+const unsigned int MAX_WIN = 128;
+const unsigned int TIMEOUT = 20000;
+const unsigned int DELAY = 1000; // microseconds each way
+const unsigned int BANDWIDTH = 1000000; // bits per second
+const unsigned int FRAMES = 500;
+
+typedef Basic_link_layer<MTU,Packet_header> Link;
+
+unsigned long data_frames_sent = 0;
+
+void send_log(char side,unsigned char buffer[],unsigned int length,
+ bool dropped,bool corrupted)
+{
+	if (side == 'a' && length > Link::HEADER_LENGTH) {
+		data_frames_sent++;
+	}
+}
+
+int main(int argc,char* argv[])
+{
+	Simulator simulator;
+	Impair impair(NULL,0,NULL,0,DELAY);
+	Basic_physical_layer<MTU> physical_layer(impair,impair,&send_log,NULL,
+	 MAX_WIN,BANDWIDTH,&simulator);
+	Link a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link::GO_BACK_N,MAX_WIN);
+	Link b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link::GO_BACK_N,MAX_WIN);
+
+	unsigned char buffer[Link::MAXIMUM_DATA_LENGTH];
+	memset(buffer,0,sizeof(buffer));
+	unsigned int sent = 0;
+	unsigned int received = 0;
+	while (received < FRAMES) {
+		bool idle = true;
+		while (sent < FRAMES
+		 && a_link_layer.send(buffer,Link::MAXIMUM_DATA_LENGTH) > 0) {
+			sent++;
+			idle = false;
+		}
+		while (b_link_layer.receive(buffer) > 0) {
+			received++;
+			idle = false;
+		}
+		if (idle && received < FRAMES && !simulator.step()) {
+			cout << "FAIL: the simulation stalled" << endl;
+			return 1;
+		}
+	}
+
+	struct timeval elapsed = simulator.now();
+	double seconds = elapsed.tv_sec+elapsed.tv_usec/1000000.0;
+	double capacity = BANDWIDTH/8.0*Link::MAXIMUM_DATA_LENGTH/MTU;
+	double efficiency = FRAMES*Link::MAXIMUM_DATA_LENGTH/seconds/capacity;
+	double transmissions = (double) data_frames_sent/FRAMES;
+	cout << "efficiency " << efficiency << ", transmissions per frame "
+	 << transmissions << endl;
+	if (efficiency < 0.9 || transmissions > 1.1) {
+		cout << "FAIL: the timeout never caught up with the round trip"
+		 << endl;
+		return 1;
+	}
+	cout << "ok" << endl;
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "link_layer.h"
+#include "timeval_operators.h"
+
+using namespace std;
+
+// Multi-link scaling benchmark: runs num_links independent
+// Physical_layer + Link_layer pairs in one process, each driven by its
+// own application thread, and reports aggregate frames/sec.
+
+const unsigned int NUM_SEQ = 10;
+const unsigned int MAX_WIN = 3;
+const unsigned int TIMEOUT = 100000;
+
+struct Link_pair {
+	Physical_layer *physical_layer;
+	Link_layer *a_link_layer;
+	Link_layer *b_link_layer;
+	unsigned int frames;
+	pthread_t thread;
+};
+
+void* send_frames(void* arg)
+{
+	Link_pair *pair = (Link_pair*) arg;
+	unsigned char send_buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	unsigned char receive_buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+
+	unsigned int send_count = 0;
+	unsigned int receive_count = 0;
+
+	send_buffer[0] = 0;
+	while (send_count < pair->frames || receive_count < pair->frames) {
+		if (send_count < pair->frames &&
+		 pair->a_link_layer->send(send_buffer,1) == 1) {
+			send_buffer[0]++;
+			send_count++;
+		}
+		if (pair->b_link_layer->receive(receive_buffer) > 0) {
+			receive_count++;
+		}
+	}
+	return NULL;
+}
+
+double run(unsigned int num_links,unsigned int frames)
+{
+	Impair impair(NULL,0,NULL,0,0);
+	Link_pair *pairs = new Link_pair[num_links];
+
+	for (unsigned int i = 0; i < num_links; i++) {
+		pairs[i].physical_layer = new Physical_layer(impair,impair,NULL,NULL);
+		pairs[i].a_link_layer = new Link_layer(
+		 pairs[i].physical_layer->get_a_interface(),
+		 NUM_SEQ,MAX_WIN,TIMEOUT);
+		pairs[i].b_link_layer = new Link_layer(
+		 pairs[i].physical_layer->get_b_interface(),
+		 NUM_SEQ,MAX_WIN,TIMEOUT);
+		pairs[i].frames = frames;
+	}
+
+	struct timeval start,stop;
+	gettimeofday(&start,NULL);
+	for (unsigned int i = 0; i < num_links; i++) {
+		pthread_create(&pairs[i].thread,NULL,&send_frames,&pairs[i]);
+	}
+	for (unsigned int i = 0; i < num_links; i++) {
+		pthread_join(pairs[i].thread,NULL);
+	}
+	gettimeofday(&stop,NULL);
+
+	for (unsigned int i = 0; i < num_links; i++) {
+		delete pairs[i].a_link_layer;
+		delete pairs[i].b_link_layer;
+		delete pairs[i].physical_layer;
+	}
+	delete[] pairs;
+
+	struct timeval elapsed = stop-start;
+	return elapsed.tv_sec+elapsed.tv_usec/1000000.0;
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 3) {
+		cout << "Syntax: " << argv[0] <<
+		 " max_links frames_per_link" << endl;
+		exit(1);
+	}
+	unsigned int max_links = atoi(argv[1]);
+	unsigned int frames = atoi(argv[2]);
+
+	cout << "links\tframes\tseconds\tframes/sec" << endl;
+	for (unsigned int n = 1; n <= max_links; n *= 2) {
+		double seconds = run(n,frames);
+		cout << n << "\t" << n*frames << "\t"
+		 << fixed << setprecision(3) << seconds << "\t"
+		 << setprecision(0) << n*frames/seconds << endl;
+	}
+
+	return 0;
+}
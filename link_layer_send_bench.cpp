@@ -0,0 +1,87 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+#include "link_layer.h"
+
+using namespace std;
+
+// send() microbenchmark: times each call in bursts of back-to-back send()
+// calls into an empty send ring, then waits for the burst to be delivered.
+// Reports the median and mean cost of an accepted send(), less the cost of
+// reading the clock. On a single core the mean includes time the woken
+// protocol thread steals from the caller.
+
+const unsigned int NUM_SEQ = 1024;
+const unsigned int MAX_WIN = 512;
+const unsigned int TIMEOUT = 100000;
+
+double now_ns()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec*1e9+t.tv_nsec;
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 3) {
+		cout << "Syntax: " << argv[0] << " bursts payload_length" << endl;
+		exit(1);
+	}
+	unsigned int bursts = atoi(argv[1]);
+	unsigned int length = atoi(argv[2]);
+
+	Impair impair(NULL,0,NULL,0,0);
+	Physical_layer physical_layer(impair,impair,NULL,NULL);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::GO_BACK_N,MAX_WIN);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::GO_BACK_N,MAX_WIN);
+
+	unsigned char send_buffer[Link_layer::MAXIMUM_DATA_LENGTH] = {0};
+	unsigned char receive_buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	vector<double> samples;
+
+	// cost of the timing itself
+	double clock_cost = now_ns();
+	for (unsigned int i = 0; i < 1000; i++) {
+		now_ns();
+	}
+	clock_cost = (now_ns()-clock_cost)/1000;
+
+	for (unsigned int b = 0; b < bursts; b++) {
+		unsigned int accepted = 0;
+		for (unsigned int i = 0; i < MAX_WIN; i++) {
+			double start = now_ns();
+			unsigned int n = a_link_layer.send(send_buffer,length);
+			double stop = now_ns();
+			if (n > 0) {
+				samples.push_back(stop-start-clock_cost);
+				accepted++;
+			}
+		}
+
+		unsigned int received = 0;
+		while (received < accepted) {
+			if (b_link_layer.receive(receive_buffer) > 0) {
+				received++;
+			}
+		}
+	}
+
+	double total = 0;
+	for (unsigned int i = 0; i < samples.size(); i++) {
+		total += samples[i];
+	}
+	sort(samples.begin(),samples.end());
+
+	cout << "sends\tp50 ns\tmean ns" << endl;
+	cout << samples.size() << "\t" << fixed << setprecision(1)
+	 << samples[samples.size()/2] << "\t" << total/samples.size() << endl;
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "bulk_transfer.h"
+
+using namespace std;
+
+// Simulation benchmark: sends full-size frames a -> b with selective
+// repeat over a lossy 100 ms RTT, 1 Mbit/s Physical_layer, once in real
+// time and twice on a Simulator with the same seed. Reports simulated and
+// wall-clock seconds for each run, and a hash of the virtual time each
+// frame was received at; the two virtual runs must agree.
+
+const unsigned int NUM_SEQ = 32;
+const unsigned int MAX_WIN = 16;
+const unsigned int TIMEOUT = 300000;
+const unsigned int DELAY = 50000; // microseconds each way
+const unsigned int BANDWIDTH = 1000000; // bits per second
+const unsigned int QUEUE_DEPTH = 64;
+const double DROP_RATE = 0.02;
+
+struct Result {
+	double simulated; // seconds of link time
+	double wall;
+	unsigned long long hash; // of receive times, virtual runs only
+};
+
+// fold a frame's receive time into the hash
+void hash_time(void* hash,const struct timeval& t)
+{
+	unsigned long long& h = *(unsigned long long*) hash;
+	h = (h ^ (t.tv_sec*1000000ull+t.tv_usec))*1099511628211ull;
+}
+
+Result run(Simulator* simulator,unsigned int frames,unsigned int seed)
+{
+	double drop[] = {DROP_RATE};
+	Impair impair(drop,1,NULL,0,DELAY,seed);
+	Physical_layer physical_layer(impair,impair,NULL,NULL,
+	 QUEUE_DEPTH,BANDWIDTH,simulator);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::SELECTIVE_REPEAT);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::SELECTIVE_REPEAT);
+
+	Result result;
+	result.hash = 14695981039346656037ull; // FNV-1a
+	Bulk_transfer<Link_layer> transfer(a_link_layer,b_link_layer,simulator);
+	transfer.set_receive_log(&hash_time,&result.hash);
+	if (!transfer.run(frames)) {
+		cout << "simulation stalled" << endl;
+		exit(1);
+	}
+	result.simulated = transfer.get_seconds();
+	result.wall = transfer.get_wall_seconds();
+	return result;
+}
+
+void report(const char* mode,unsigned int frames,const Result& r)
+{
+	cout << mode << "\t" << frames << "\t" << fixed << setprecision(3)
+	 << r.simulated << "\t" << r.wall << "\t" << setprecision(0)
+	 << r.simulated/r.wall << "\t" << hex << r.hash << dec << endl;
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 4) {
+		cout << "Syntax: " << argv[0]
+		 << " virtual_frames real_frames seed" << endl;
+		exit(1);
+	}
+	unsigned int virtual_frames = atoi(argv[1]);
+	unsigned int real_frames = atoi(argv[2]);
+	unsigned int seed = atoi(argv[3]);
+
+	cout << "mode\tframes\tlink s\twall s\tspeedup\treceive time hash"
+	 << endl;
+
+	Result real = run(NULL,real_frames,seed);
+	real.hash = 0;
+	report("real",real_frames,real);
+
+	Simulator simulator0;
+	Result virtual0 = run(&simulator0,virtual_frames,seed);
+	report("virtual",virtual_frames,virtual0);
+
+	Simulator simulator1;
+	Result virtual1 = run(&simulator1,virtual_frames,seed);
+	report("virtual",virtual_frames,virtual1);
+
+	if (virtual0.hash != virtual1.hash
+	 || virtual0.simulated != virtual1.simulated) {
+		cout << "virtual runs differ" << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+#include "link_layer.h"
+#include "simulator.h"
+#include "timeval_operators.h"
+
+using namespace std;
+
+// Selective repeat test: frames a -> b over a path that drops, reorders
+// and duplicates them, with a sequence space of 16 so that the numbers
+// wrap nearly two hundred times. Every frame must reach b once, whole and
+// in the order it was sent. A frame overtaken again and again falls
+// behind without bound; 16 keeps one from outliving a whole sequence
+// space in any likely run
+
+const unsigned int NUM_SEQ = 16;
+const unsigned int MAX_WIN = 4;
+const unsigned int TIMEOUT = 20000;
+const unsigned int DELAY = 5000; // microseconds each way
+const unsigned int BANDWIDTH = 1000000; // bits per second
+const unsigned int FRAMES = 3000;
+
+int main(int argc,char* argv[])
+{
+	Simulator simulator;
+	double drop[] = {0.05};
+	Impair impair(drop,1,NULL,0,DELAY,7);
+	impair.set_jitter(Impair::JITTER_UNIFORM,DELAY);
+	impair.set_reorder(0.2);
+	impair.set_duplicate(0.1);
+	Physical_layer physical_layer(impair,impair,NULL,NULL,
+	 2*MAX_WIN,BANDWIDTH,&simulator);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::SELECTIVE_REPEAT);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::SELECTIVE_REPEAT);
+
+	unsigned char send_buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	unsigned char receive_buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	unsigned int sent = 0;
+	unsigned int received = 0;
+	while (received < FRAMES) {
+		// frame i is i+1 bytes long modulo the largest, each byte i
+		while (sent < FRAMES) {
+			unsigned int length = sent%Link_layer::MAXIMUM_DATA_LENGTH+1;
+			memset(send_buffer,sent,length);
+			if (a_link_layer.send(send_buffer,length) == 0) {
+				break;
+			}
+			sent++;
+		}
+		unsigned int length;
+		while ((length = b_link_layer.receive(receive_buffer)) > 0) {
+			unsigned int expected =
+			 received%Link_layer::MAXIMUM_DATA_LENGTH+1;
+			bool same = length == expected;
+			for (unsigned int i = 0; same && i < length; i++) {
+				same = receive_buffer[i] == (unsigned char) received;
+			}
+			if (!same) {
+				cout << "FAIL: frame " << received
+				 << " is missing, repeated or out of order" << endl;
+				return 1;
+			}
+			received++;
+		}
+		if (received < FRAMES && !simulator.step()) {
+			cout << "FAIL: the simulation stalled after " << received
+			 << " frames" << endl;
+			return 1;
+		}
+	}
+
+	// nothing more may turn up once the path has drained
+	while (simulator.step()) {
+		if (b_link_layer.receive(receive_buffer) > 0) {
+			cout << "FAIL: a frame was delivered twice" << endl;
+			return 1;
+		}
+	}
+	cout << "ok" << endl;
+	return 0;
+}
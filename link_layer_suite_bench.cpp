@@ -0,0 +1,280 @@
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bulk_transfer.h"
+
+using namespace std;
+
+// Benchmark suite: a bulk one-way transfer of full-size frames a -> b
+// over a grid of link configurations, for tracking performance from run
+// to run. Starting from a baseline, each sweep varies one of window size,
+// sequence space, initial timeout, drop rate, corruption rate and delay,
+// with go-back-N and selective repeat. Every frame carries its number;
+// the time from the send that accepted it to the receive that returned
+// it is its latency. For each configuration the suite reports goodput,
+// frames per second and the 50th, 99th and 99.9th latency percentiles,
+// as CSV or JSON.
+//
+// On a Simulator (the default) times are virtual, so a run depends only
+// on its arguments and two runs can be diffed; only wall_s, the host time
+// the run took, varies. With "real" the links run in real time on their
+// own threads.
+
+const unsigned int BANDWIDTH = 10000000; // bits per second
+
+// baseline; each sweep moves one parameter away from it
+const unsigned int WINDOW = 16;
+const unsigned int NUM_SEQ = 64;
+const unsigned int TIMEOUT = 20000; // initial; the link adapts it
+const double DROP = 0.01;
+const double CORRUPT = 0.0;
+const unsigned int DELAY = 1000; // microseconds each way
+
+const unsigned int WINDOWS[] = {1,2,4,8,16,32};
+const unsigned int NUM_SEQS[] = {32,64,256,1024};
+const unsigned int TIMEOUTS[] = {1000,20000,200000,1000000};
+const double DROPS[] = {0.0,0.01,0.05,0.1,0.2};
+const double CORRUPTS[] = {0.0,0.01,0.05,0.1};
+const unsigned int DELAYS[] = {0,1000,10000,100000};
+
+struct Config {
+	Link_layer::Arq_mode arq_mode;
+	unsigned int window;
+	unsigned int num_seq;
+	unsigned int timeout;
+	double drop;
+	double corrupt;
+	unsigned int delay;
+};
+
+struct Result {
+	bool completed; // false if the simulation stalled
+	double seconds; // link time
+	double wall; // host time
+	unsigned long data_frames; // a -> b, retransmissions included
+	unsigned long ack_frames; // b -> a
+	unsigned long p50,p99,p999; // latency in microseconds
+};
+
+Result run(const Config& config,unsigned int frames,unsigned int seed,
+ bool real_time)
+{
+	Result result;
+	vector<unsigned long> latencies;
+	latencies.reserve(frames);
+
+	Simulator simulator;
+	Simulator* s = real_time ? NULL : &simulator;
+	double drop[] = {config.drop};
+	double corrupt[] = {config.corrupt};
+	Impair a_impair(drop,1,corrupt,1,config.delay,seed);
+	Impair b_impair(drop,1,corrupt,1,config.delay,seed+1);
+	Physical_layer physical_layer(a_impair,b_impair,NULL,NULL,
+	 config.window,BANDWIDTH,s);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 config.num_seq,config.window,config.timeout,config.arq_mode,
+	 config.window);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 config.num_seq,config.window,config.timeout,config.arq_mode,
+	 config.window);
+
+	Bulk_transfer<Link_layer> transfer(a_link_layer,b_link_layer,s);
+	transfer.set_latencies(&latencies);
+	result.completed = transfer.run(frames);
+	result.seconds = transfer.get_seconds();
+	result.wall = transfer.get_wall_seconds();
+	result.data_frames =
+	 physical_layer.get_a_interface()->get_metrics().frames_sent;
+	result.ack_frames =
+	 physical_layer.get_b_interface()->get_metrics().frames_sent;
+	result.p50 = percentile(latencies,0.5);
+	result.p99 = percentile(latencies,0.99);
+	result.p999 = percentile(latencies,0.999);
+	return result;
+}
+
+// one output row: column names and their values, already formatted
+typedef vector<pair<string,string> > Row;
+
+template <class T>
+string format(T value)
+{
+	ostringstream s;
+	s << value;
+	return s.str();
+}
+
+string format(double value,int precision)
+{
+	ostringstream s;
+	s << fixed << setprecision(precision) << value;
+	return s.str();
+}
+
+Row make_row(const char* sweep,const Config& config,unsigned int frames,
+ const Result& r)
+{
+	bool ok = r.completed && r.seconds > 0;
+	Row row;
+	row.push_back(make_pair("sweep",string(sweep)));
+	row.push_back(make_pair("arq",string(
+	 config.arq_mode == Link_layer::GO_BACK_N ? "gbn" : "sr")));
+	row.push_back(make_pair("window",format(config.window)));
+	row.push_back(make_pair("num_seq",format(config.num_seq)));
+	row.push_back(make_pair("timeout_us",format(config.timeout)));
+	row.push_back(make_pair("drop",format(config.drop,3)));
+	row.push_back(make_pair("corrupt",format(config.corrupt,3)));
+	row.push_back(make_pair("delay_us",format(config.delay)));
+	row.push_back(make_pair("frames",format(frames)));
+	row.push_back(make_pair("completed",format(r.completed ? 1 : 0)));
+	row.push_back(make_pair("seconds",format(r.seconds,6)));
+	row.push_back(make_pair("goodput_Bps",format(ok ? (double) frames
+	 *Link_layer::MAXIMUM_DATA_LENGTH/r.seconds : 0.0,0)));
+	row.push_back(make_pair("frames_per_s",format(ok ? frames/r.seconds
+	 : 0.0,1)));
+	row.push_back(make_pair("data_frames_per_frame",
+	 format((double) r.data_frames/frames,3)));
+	row.push_back(make_pair("ack_frames_per_frame",
+	 format((double) r.ack_frames/frames,3)));
+	row.push_back(make_pair("p50_us",format(r.p50)));
+	row.push_back(make_pair("p99_us",format(r.p99)));
+	row.push_back(make_pair("p999_us",format(r.p999)));
+	row.push_back(make_pair("wall_s",format(r.wall,6)));
+	return row;
+}
+
+bool stalled = false;
+
+void measure(vector<Row>& rows,const char* sweep,const Config& config,
+ unsigned int frames,unsigned int seed,bool real_time)
+{
+	Result result = run(config,frames,seed,real_time);
+	stalled = stalled || !result.completed;
+	rows.push_back(make_row(sweep,config,frames,result));
+}
+
+// every value but sweep and arq is a number
+void write_csv(ostream& out,const vector<Row>& rows)
+{
+	for (size_t i = 0; i < rows.size(); i++) {
+		if (i == 0) {
+			for (size_t j = 0; j < rows[i].size(); j++) {
+				out << (j > 0 ? "," : "") << rows[i][j].first;
+			}
+			out << "\n";
+		}
+		for (size_t j = 0; j < rows[i].size(); j++) {
+			out << (j > 0 ? "," : "") << rows[i][j].second;
+		}
+		out << "\n";
+	}
+}
+
+void write_json(ostream& out,const vector<Row>& rows,unsigned int frames,
+ unsigned int seed,bool real_time)
+{
+	out << "{\n\"benchmark\": \"link_layer_suite\",\n\"clock\": \""
+	 << (real_time ? "real" : "simulated") << "\",\n\"frames\": " << frames
+	 << ",\n\"seed\": " << seed << ",\n\"bandwidth\": " << BANDWIDTH
+	 << ",\n\"frame_data_length\": " << Link_layer::MAXIMUM_DATA_LENGTH
+	 << ",\n\"results\": [\n";
+	for (size_t i = 0; i < rows.size(); i++) {
+		out << "{";
+		for (size_t j = 0; j < rows[i].size(); j++) {
+			const string& name = rows[i][j].first;
+			bool quoted = name == "sweep" || name == "arq";
+			out << (j > 0 ? ", " : "") << "\"" << name << "\": "
+			 << (quoted ? "\"" : "") << rows[i][j].second
+			 << (quoted ? "\"" : "");
+		}
+		out << "}" << (i+1 < rows.size() ? "," : "") << "\n";
+	}
+	out << "]\n}\n";
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc < 4 || argc > 6
+	 || (strcmp(argv[3],"csv") != 0 && strcmp(argv[3],"json") != 0)
+	 || (argc == 6 && strcmp(argv[5],"real") != 0)) {
+		cout << "Syntax: " << argv[0]
+		 << " frames seed csv|json [output_file|- [real]]" << endl;
+		exit(1);
+	}
+	unsigned int frames = atoi(argv[1]);
+	unsigned int seed = atoi(argv[2]);
+	bool json = strcmp(argv[3],"json") == 0;
+	const char* file = argc >= 5 && strcmp(argv[4],"-") != 0 ? argv[4] : NULL;
+	bool real_time = argc == 6;
+
+	vector<Row> rows;
+	Link_layer::Arq_mode arq_modes[] = {Link_layer::GO_BACK_N,
+	 Link_layer::SELECTIVE_REPEAT};
+	for (unsigned int m = 0; m < 2; m++) {
+		Config baseline = {arq_modes[m],WINDOW,NUM_SEQ,TIMEOUT,DROP,CORRUPT,
+		 DELAY};
+		// selective repeat needs num_seq >= 2*window, so the sequence
+		// space sweep starts at 2*WINDOW for both
+		for (unsigned int i = 0; i < sizeof(WINDOWS)/sizeof(WINDOWS[0]);
+		 i++) {
+			Config c = baseline;
+			c.window = WINDOWS[i];
+			measure(rows,"window",c,frames,seed,real_time);
+		}
+		for (unsigned int i = 0; i < sizeof(NUM_SEQS)/sizeof(NUM_SEQS[0]);
+		 i++) {
+			Config c = baseline;
+			c.num_seq = NUM_SEQS[i];
+			measure(rows,"num_seq",c,frames,seed,real_time);
+		}
+		for (unsigned int i = 0; i < sizeof(TIMEOUTS)/sizeof(TIMEOUTS[0]);
+		 i++) {
+			Config c = baseline;
+			c.timeout = TIMEOUTS[i];
+			measure(rows,"timeout",c,frames,seed,real_time);
+		}
+		for (unsigned int i = 0; i < sizeof(DROPS)/sizeof(DROPS[0]); i++) {
+			Config c = baseline;
+			c.drop = DROPS[i];
+			measure(rows,"drop",c,frames,seed,real_time);
+		}
+		for (unsigned int i = 0; i < sizeof(CORRUPTS)/sizeof(CORRUPTS[0]);
+		 i++) {
+			Config c = baseline;
+			c.corrupt = CORRUPTS[i];
+			measure(rows,"corrupt",c,frames,seed,real_time);
+		}
+		for (unsigned int i = 0; i < sizeof(DELAYS)/sizeof(DELAYS[0]); i++) {
+			Config c = baseline;
+			c.delay = DELAYS[i];
+			measure(rows,"delay",c,frames,seed,real_time);
+		}
+	}
+
+	ofstream file_out;
+	if (file != NULL) {
+		file_out.open(file);
+		if (!file_out) {
+			cerr << "cannot write " << file << endl;
+			exit(1);
+		}
+	}
+	ostream& out = file != NULL ? file_out : cout;
+	if (json) {
+		write_json(out,rows,frames,seed,real_time);
+	} else {
+		write_csv(out,rows);
+	}
+
+	if (stalled) {
+		cerr << "a simulation stalled" << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,314 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+#include "bulk_transfer.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// Parameter sweep: a bulk transfer a -> b of full frames for every
+// combination of a grid of link settings and impairment profiles, each on
+// a Simulator of its own, run concurrently on a Thread_pool. Simulated
+// runs start no threads and share nothing, so any of them may run on any
+// pool thread. The grid is given as key=value,value,... arguments:
+//
+//	arq		gbn, sr
+//	num_seq		sequence numbers
+//	window		max_send_window_size, also the queue depth
+//	timeout		initial, in microseconds
+//	delay		microseconds each way
+//	profile		impairment, from PROFILES below
+//	seed		one run per seed
+//
+// Keys left out take their defaults. Combinations Link_layer rejects,
+// such as a selective repeat window over num_seq/2, are skipped. Results
+// come out as one CSV table in grid order, whatever order the runs
+// finished in; run times are virtual, so a sweep repeats exactly on any
+// number of threads. A summary, with the sweep's wall time, goes to
+// standard error.
+
+const unsigned int BANDWIDTH = 10000000; // bits per second
+
+struct Profile {
+	const char* name;
+	double drop;
+	double corrupt;
+	Burst_loss burst_loss; // used if good_to_bad > 0
+	Impair::Jitter jitter;
+	unsigned int jitter_mean;
+	double reorder;
+	double duplicate;
+};
+
+const Profile PROFILES[] = {
+	{"clean",0.0,0.0,{0,0,0,0},Impair::JITTER_NONE,0,0.0,0.0},
+	{"loss1",0.01,0.0,{0,0,0,0},Impair::JITTER_NONE,0,0.0,0.0},
+	{"loss5",0.05,0.0,{0,0,0,0},Impair::JITTER_NONE,0,0.0,0.0},
+	// 2% on average, in bursts of 4 frames
+	{"burst",0.0,0.0,{0.0051,0.25,0.0,1.0},Impair::JITTER_NONE,0,0.0,0.0},
+	{"corrupt1",0.0,0.01,{0,0,0,0},Impair::JITTER_NONE,0,0.0,0.0},
+	{"jitter",0.0,0.0,{0,0,0,0},Impair::JITTER_EXPONENTIAL,1000,0.0,0.0},
+	{"reorder",0.0,0.0,{0,0,0,0},Impair::JITTER_NONE,0,0.02,0.0},
+	{"duplicate",0.0,0.0,{0,0,0,0},Impair::JITTER_NONE,0,0.0,0.02},
+};
+const unsigned int NUM_PROFILES = sizeof(PROFILES)/sizeof(PROFILES[0]);
+
+struct Config {
+	Link_layer::Arq_mode arq_mode;
+	unsigned int num_seq;
+	unsigned int window;
+	unsigned int timeout;
+	unsigned int delay;
+	const Profile* profile;
+	unsigned int seed;
+};
+
+struct Run {
+	Config config;
+	unsigned int frames;
+	// results
+	bool completed; // false if the simulation stalled
+	double seconds; // link time
+	unsigned long retransmissions;
+	unsigned long timeouts;
+	unsigned long p50,p99,p999; // latency in microseconds
+};
+
+Impair make_impair(const Config& config,unsigned int seed)
+{
+	const Profile& profile = *config.profile;
+	double drop[] = {profile.drop};
+	double corrupt[] = {profile.corrupt};
+	Impair impair(drop,1,corrupt,1,config.delay,seed);
+	if (profile.burst_loss.good_to_bad > 0) {
+		impair.set_burst_loss(profile.burst_loss);
+	}
+	impair.set_jitter(profile.jitter,profile.jitter_mean);
+	impair.set_reorder(profile.reorder);
+	impair.set_duplicate(profile.duplicate);
+	return impair;
+}
+
+// one run, on whichever pool thread takes it
+void run(void* run0)
+{
+	Run& r = *(Run*) run0;
+	const Config& config = r.config;
+	vector<unsigned long> latencies;
+	latencies.reserve(r.frames);
+
+	Simulator simulator;
+	Impair a_impair = make_impair(config,config.seed);
+	Impair b_impair = make_impair(config,config.seed+1);
+	Physical_layer physical_layer(a_impair,b_impair,NULL,NULL,
+	 config.window,BANDWIDTH,&simulator);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 config.num_seq,config.window,config.timeout,config.arq_mode,
+	 config.window);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 config.num_seq,config.window,config.timeout,config.arq_mode,
+	 config.window);
+
+	Bulk_transfer<Link_layer> transfer(a_link_layer,b_link_layer,
+	 &simulator);
+	transfer.set_latencies(&latencies);
+	r.completed = transfer.run(r.frames);
+
+	Link_metrics metrics = a_link_layer.get_metrics();
+	r.seconds = transfer.get_seconds();
+	r.retransmissions = metrics.retransmissions;
+	r.timeouts = metrics.timeouts;
+	r.p50 = percentile(latencies,0.5);
+	r.p99 = percentile(latencies,0.99);
+	r.p999 = percentile(latencies,0.999);
+}
+
+// Link_layer's own checks, so that no run throws
+bool valid(const Config& config)
+{
+	if (config.window == 0 || config.window >= config.num_seq) {
+		return false;
+	}
+	return config.arq_mode != Link_layer::SELECTIVE_REPEAT
+	 || (config.window <= config.num_seq/2
+	 && config.window <= Link_layer::SACK_BITS);
+}
+
+void syntax(const char* program)
+{
+	cerr << "Syntax: " << program << " frames threads [key=value,...]..."
+	 << endl << "keys: arq num_seq window timeout delay profile seed"
+	 << endl << "profiles:";
+	for (unsigned int i = 0; i < NUM_PROFILES; i++) {
+		cerr << " " << PROFILES[i].name;
+	}
+	cerr << endl;
+	exit(1);
+}
+
+// the comma-separated values of "key=values", or exit
+vector<string> split(const char* program,const string& values)
+{
+	vector<string> result;
+	size_t begin = 0;
+	while (true) {
+		size_t end = values.find(',',begin);
+		string value = values.substr(begin,end-begin);
+		if (value.empty()) {
+			syntax(program);
+		}
+		result.push_back(value);
+		if (end == string::npos) {
+			return result;
+		}
+		begin = end+1;
+	}
+}
+
+vector<unsigned int> numbers(const char* program,const vector<string>& values)
+{
+	vector<unsigned int> result;
+	for (unsigned int i = 0; i < values.size(); i++) {
+		char* end;
+		unsigned long n = strtoul(values[i].c_str(),&end,10);
+		if (*end != '\0') {
+			syntax(program);
+		}
+		result.push_back(n);
+	}
+	return result;
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc < 3) {
+		syntax(argv[0]);
+	}
+	unsigned int frames = atoi(argv[1]);
+	unsigned int threads = atoi(argv[2]);
+
+	vector<Link_layer::Arq_mode> arq_modes;
+	arq_modes.push_back(Link_layer::GO_BACK_N);
+	arq_modes.push_back(Link_layer::SELECTIVE_REPEAT);
+	vector<unsigned int> num_seqs(1,64);
+	vector<unsigned int> windows(1,16);
+	vector<unsigned int> timeouts(1,20000);
+	vector<unsigned int> delays(1,1000);
+	vector<const Profile*> profiles(1,&PROFILES[1]);
+	vector<unsigned int> seeds(1,1);
+
+	for (int i = 3; i < argc; i++) {
+		string arg = argv[i];
+		size_t equals = arg.find('=');
+		if (equals == string::npos) {
+			syntax(argv[0]);
+		}
+		string key = arg.substr(0,equals);
+		vector<string> values = split(argv[0],arg.substr(equals+1));
+		if (key == "arq") {
+			arq_modes.clear();
+			for (unsigned int j = 0; j < values.size(); j++) {
+				if (values[j] != "gbn" && values[j] != "sr") {
+					syntax(argv[0]);
+				}
+				arq_modes.push_back(values[j] == "gbn"
+				 ? Link_layer::GO_BACK_N
+				 : Link_layer::SELECTIVE_REPEAT);
+			}
+		} else if (key == "num_seq") {
+			num_seqs = numbers(argv[0],values);
+		} else if (key == "window") {
+			windows = numbers(argv[0],values);
+		} else if (key == "timeout") {
+			timeouts = numbers(argv[0],values);
+		} else if (key == "delay") {
+			delays = numbers(argv[0],values);
+		} else if (key == "seed") {
+			seeds = numbers(argv[0],values);
+		} else if (key == "profile") {
+			profiles.clear();
+			for (unsigned int j = 0; j < values.size(); j++) {
+				unsigned int k = 0;
+				while (k < NUM_PROFILES
+				 && values[j] != PROFILES[k].name) {
+					k++;
+				}
+				if (k == NUM_PROFILES) {
+					syntax(argv[0]);
+				}
+				profiles.push_back(&PROFILES[k]);
+			}
+		} else {
+			syntax(argv[0]);
+		}
+	}
+
+	// the grid, in output order
+	vector<Run> runs;
+	unsigned long skipped = 0;
+	for (unsigned int a = 0; a < arq_modes.size(); a++)
+	for (unsigned int n = 0; n < num_seqs.size(); n++)
+	for (unsigned int w = 0; w < windows.size(); w++)
+	for (unsigned int t = 0; t < timeouts.size(); t++)
+	for (unsigned int d = 0; d < delays.size(); d++)
+	for (unsigned int p = 0; p < profiles.size(); p++)
+	for (unsigned int s = 0; s < seeds.size(); s++) {
+		Run r;
+		r.config.arq_mode = arq_modes[a];
+		r.config.num_seq = num_seqs[n];
+		r.config.window = windows[w];
+		r.config.timeout = timeouts[t];
+		r.config.delay = delays[d];
+		r.config.profile = profiles[p];
+		r.config.seed = seeds[s];
+		r.frames = frames;
+		if (valid(r.config)) {
+			runs.push_back(r);
+		} else {
+			skipped++;
+		}
+	}
+
+	struct timeval start,stop;
+	gettimeofday(&start,NULL);
+	unsigned long steals;
+	{
+		Thread_pool pool(threads);
+		threads = pool.get_threads();
+		for (unsigned int i = 0; i < runs.size(); i++) {
+			pool.submit(&run,&runs[i]);
+		}
+		pool.wait();
+		steals = pool.get_steals();
+	}
+	gettimeofday(&stop,NULL);
+
+	cout << "arq,num_seq,window,timeout,delay,profile,seed,completed,"
+	 "link_s,goodput_bps,frames_per_s,retransmissions_per_frame,timeouts,"
+	 "p50_us,p99_us,p999_us" << endl;
+	for (unsigned int i = 0; i < runs.size(); i++) {
+		const Run& r = runs[i];
+		const Config& c = r.config;
+		bool ok = r.completed && r.seconds > 0;
+		double goodput = ok ? 8.0*Link_layer::MAXIMUM_DATA_LENGTH
+		 *frames/r.seconds : 0;
+		const char* arq = c.arq_mode == Link_layer::GO_BACK_N
+		 ? "gbn" : "sr";
+		cout << arq << "," << c.num_seq << "," << c.window << ","
+		 << c.timeout << "," << c.delay << "," << c.profile->name << ","
+		 << c.seed << "," << (r.completed ? 1 : 0) << "," << fixed
+		 << setprecision(6) << r.seconds << "," << setprecision(0)
+		 << goodput << "," << setprecision(1)
+		 << (ok ? frames/r.seconds : 0) << "," << setprecision(4)
+		 << (double) r.retransmissions/frames << "," << r.timeouts
+		 << "," << r.p50 << "," << r.p99 << "," << r.p999 << endl;
+	}
+
+	cerr << runs.size() << " runs (" << skipped << " skipped) on "
+	 << threads << " threads in " << fixed << setprecision(3)
+	 << seconds(stop-start) << " s, " << steals << " stolen" << endl;
+	return 0;
+}
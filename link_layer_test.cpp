@@ -35,14 +35,6 @@ void send_n(Link_layer *send_link_layer,Link_layer *receive_link_layer,int n)
 	}
 }
 
-Physical_layer physical_layer(a_impair,b_impair,NULL,NULL);
-
-Link_layer* a_link_layer = new Link_layer
- (physical_layer.get_a_interface(),num_seq,max_win,timeout);
-
-Link_layer* b_link_layer = new Link_layer
- (physical_layer.get_b_interface(),num_seq,max_win,timeout);
-
 int main(int argc,char* argv[])
 {
 	if (argc != 3) {
@@ -51,11 +43,24 @@ int main(int argc,char* argv[])
 		exit(1);
 	}
 
+	Physical_layer physical_layer(a_impair,b_impair,NULL,NULL);
+
+	Link_layer* a_link_layer = new Link_layer
+	 (physical_layer.get_a_interface(),num_seq,max_win,timeout);
+
+	Link_layer* b_link_layer = new Link_layer
+	 (physical_layer.get_b_interface(),num_seq,max_win,timeout);
+
 	cout << "----- a to b..." << endl;
 	send_n(a_link_layer,b_link_layer,atoi(argv[1]));
 
 	cout << "----- b to a..." << endl;
 	send_n(b_link_layer,a_link_layer,atoi(argv[2]));
 
+	// the links stop their loops before physical_layer frees the
+	// interfaces they use
+	delete a_link_layer;
+	delete b_link_layer;
+
 	return 0;
 }
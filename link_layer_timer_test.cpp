@@ -0,0 +1,127 @@
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+#include "link_layer.h"
+#include "simulator.h"
+#include "timeval_operators.h"
+
+using namespace std;
+
+// Retransmission timer test. Frames that are acked, sacked or rearmed
+// leave stale entries in the timer heap; none of them may fire. Over a
+// clean path no frame is resent and the links fall idle once the last
+// frame is in. Over a path that drops only data frames, selective repeat
+// resends each dropped frame once: one resend per drop, no more.
+
+const unsigned int NUM_SEQ = 64;
+const unsigned int MAX_WIN = 16;
+const unsigned int TIMEOUT = 50000;
+const unsigned int DELAY = 10000; // microseconds each way
+const unsigned int BANDWIDTH = 1000000; // bits per second
+const unsigned int FRAMES = 2000;
+
+unsigned long data_frames_dropped = 0;
+
+void send_log(char side,unsigned char buffer[],unsigned int length,
+ bool dropped,bool corrupted)
+{
+	if (side == 'a' && length > Link_layer::HEADER_LENGTH && dropped) {
+		data_frames_dropped++;
+	}
+}
+
+// send FRAMES frames a -> b; return false if the transfer stalls
+bool transfer(Simulator& simulator,Link_layer& a_link_layer,
+ Link_layer& b_link_layer)
+{
+	unsigned char buffer[Link_layer::MAXIMUM_DATA_LENGTH];
+	memset(buffer,0,sizeof(buffer));
+	unsigned int sent = 0;
+	unsigned int received = 0;
+	while (received < FRAMES) {
+		while (sent < FRAMES && a_link_layer.send(buffer,
+		 Link_layer::MAXIMUM_DATA_LENGTH) > 0) {
+			sent++;
+		}
+		while (b_link_layer.receive(buffer) > 0) {
+			received++;
+		}
+		if (received < FRAMES && !simulator.step()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool clean(Link_layer::Arq_mode arq_mode,const char* name)
+{
+	Simulator simulator;
+	Impair impair(NULL,0,NULL,0,DELAY);
+	Physical_layer physical_layer(impair,impair,NULL,NULL,
+	 2*MAX_WIN,BANDWIDTH,&simulator);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,arq_mode);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,arq_mode);
+	if (!transfer(simulator,a_link_layer,b_link_layer)) {
+		cout << "FAIL: " << name << " stalled on a clean path" << endl;
+		return false;
+	}
+
+	// the last acks are in flight; after them nothing is left to do
+	struct timeval done = simulator.now();
+	while (simulator.step()) {
+	}
+	struct timeval idle = simulator.now()-done;
+	Link_metrics metrics = a_link_layer.get_metrics();
+	if (metrics.retransmissions != 0 || metrics.timeouts != 0) {
+		cout << "FAIL: " << name << " resent "
+		 << metrics.retransmissions << " frames on a clean path"
+		 << endl;
+		return false;
+	}
+	if (idle.tv_sec*1000000+idle.tv_usec > 2*DELAY+Link_layer::ACK_DELAY) {
+		cout << "FAIL: " << name << " woke " << idle.tv_sec*1000000
+		 +idle.tv_usec << " us after the last frame" << endl;
+		return false;
+	}
+	return true;
+}
+
+bool lossy()
+{
+	Simulator simulator;
+	double drop[] = {0.05};
+	Impair data(drop,1,NULL,0,DELAY,3);
+	Impair acks(NULL,0,NULL,0,DELAY);
+	Physical_layer physical_layer(data,acks,&send_log,NULL,
+	 2*MAX_WIN,BANDWIDTH,&simulator);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::SELECTIVE_REPEAT);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::SELECTIVE_REPEAT);
+	if (!transfer(simulator,a_link_layer,b_link_layer)) {
+		cout << "FAIL: selective repeat stalled" << endl;
+		return false;
+	}
+	Link_metrics metrics = a_link_layer.get_metrics();
+	if (data_frames_dropped == 0
+	 || metrics.retransmissions != data_frames_dropped) {
+		cout << "FAIL: " << metrics.retransmissions << " resends for "
+		 << data_frames_dropped << " dropped frames" << endl;
+		return false;
+	}
+	return true;
+}
+
+int main(int argc,char* argv[])
+{
+	if (!clean(Link_layer::GO_BACK_N,"go-back-N")
+	 || !clean(Link_layer::SELECTIVE_REPEAT,"selective repeat")
+	 || !lossy()) {
+		return 1;
+	}
+	cout << "ok" << endl;
+	return 0;
+}
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "bulk_transfer.h"
+#include "trace.h"
+
+using namespace std;
+
+// Trace benchmark: the cost of tracing every frame. Sends full frames
+// a -> b in real time over an unimpaired link, alternately untraced and
+// with both interfaces traced to a file by a Trace_writer, and reports
+// the best frame rate of each and the traced rate's shortfall.
+
+const unsigned int NUM_SEQ = 256;
+const unsigned int MAX_WIN = 128;
+const unsigned int TIMEOUT = 20000; // initial; the link adapts it
+
+// frames per second a -> b, traced to writer unless it is NULL
+double frame_rate(unsigned int frames,Trace_writer* writer)
+{
+	Impair impair(NULL,0,NULL,0,0);
+	Physical_layer physical_layer(impair,impair,NULL,NULL,MAX_WIN);
+	if (writer != NULL) {
+		physical_layer.get_a_interface()->set_trace(writer->add_ring());
+		physical_layer.get_b_interface()->set_trace(writer->add_ring());
+	}
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::GO_BACK_N,MAX_WIN);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::GO_BACK_N,MAX_WIN);
+
+	Bulk_transfer<Link_layer> transfer(a_link_layer,b_link_layer,NULL);
+	transfer.run(frames);
+
+	physical_layer.get_a_interface()->set_trace(NULL);
+	physical_layer.get_b_interface()->set_trace(NULL);
+	return frames/transfer.get_wall_seconds();
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 4) {
+		cout << "Syntax: " << argv[0] << " frames runs trace_file" << endl;
+		exit(1);
+	}
+	unsigned int frames = atoi(argv[1]);
+	unsigned int runs = atoi(argv[2]);
+
+	Trace_writer writer(argv[3]);
+	double untraced = 0;
+	double traced = 0;
+	for (unsigned int i = 0; i < runs; i++) {
+		double rate = frame_rate(frames,NULL);
+		untraced = rate > untraced ? rate : untraced;
+		rate = frame_rate(frames,&writer);
+		traced = rate > traced ? rate : traced;
+	}
+	writer.flush();
+
+	cout << "untraced frames/s\ttraced frames/s\tcost %\trecords\tdropped"
+	 << endl;
+	cout << fixed << setprecision(0) << untraced << "\t" << traced << "\t"
+	 << setprecision(1) << 100*(1-traced/untraced) << "\t"
+	 << writer.get_records_written() << "\t"
+	 << writer.get_records_dropped() << endl;
+	return 0;
+}
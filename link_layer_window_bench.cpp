@@ -0,0 +1,56 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "bulk_transfer.h"
+
+using namespace std;
+
+// Window benchmark: sends the same number of full-size frames a -> b over
+// a Physical_layer with propagation delay and bandwidth, at growing send
+// window sizes, once with a channel that holds one frame and once with a
+// queue deep enough for the largest window. Only the deep channel lets a
+// larger window keep more frames in flight.
+
+const unsigned int NUM_SEQ = 64;
+const unsigned int TIMEOUT = 200000;
+const unsigned int DELAY = 2000; // microseconds each way
+const unsigned int BANDWIDTH = 1000000; // bits per second
+const unsigned int QUEUE_DEPTH = 64;
+
+double run(unsigned int max_win,unsigned int queue_depth,unsigned int frames)
+{
+	Impair impair(NULL,0,NULL,0,DELAY);
+	Physical_layer physical_layer(impair,impair,NULL,NULL,
+	 queue_depth,BANDWIDTH);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,max_win,TIMEOUT,Link_layer::GO_BACK_N,QUEUE_DEPTH);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,max_win,TIMEOUT,Link_layer::GO_BACK_N,QUEUE_DEPTH);
+
+	Bulk_transfer<Link_layer> transfer(a_link_layer,b_link_layer,NULL);
+	transfer.run(frames);
+	return frames*Link_layer::MAXIMUM_DATA_LENGTH
+	 /transfer.get_wall_seconds();
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 2) {
+		cout << "Syntax: " << argv[0] << " frames" << endl;
+		exit(1);
+	}
+	unsigned int frames = atoi(argv[1]);
+
+	cout << "delay " << DELAY << " us, bandwidth " << BANDWIDTH
+	 << " b/s" << endl;
+	cout << "window\tdepth 1 B/s\tdepth " << QUEUE_DEPTH << " B/s" << endl;
+	for (unsigned int max_win = 1; max_win <= 32; max_win *= 2) {
+		double shallow = run(max_win,1,frames);
+		double deep = run(max_win,QUEUE_DEPTH,frames);
+		cout << max_win << "\t" << fixed << setprecision(0)
+		 << shallow << "\t" << deep << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,197 @@
+echo ---------- compiling physical_layer.cpp
+g++ -O2 -g -c -Wall -o physical_layer_bench.o physical_layer.cpp
+
+echo ---------- compiling checksum.cpp
+g++ -O2 -g -c -Wall -o checksum_bench.o checksum.cpp
+
+echo ---------- compiling simulator.cpp
+g++ -O2 -g -c -Wall -o simulator_bench.o simulator.cpp
+
+echo ---------- compiling reactor.cpp
+g++ -O2 -g -c -Wall -o reactor_bench.o reactor.cpp
+
+echo ---------- compiling link_layer.cpp
+g++ -O2 -g -c -Wall -o link_layer_bench.o link_layer.cpp
+
+echo ---------- compiling link_layer_scaling_bench.cpp
+g++ -O2 -g -c -Wall link_layer_scaling_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_scaling_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_scaling_bench.o -lpthread
+
+echo ---------- compiling link_layer_arq_bench.cpp
+g++ -O2 -g -c -Wall link_layer_arq_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_arq_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_arq_bench.o -lpthread
+
+echo ---------- compiling link_layer_send_bench.cpp
+g++ -O2 -g -c -Wall link_layer_send_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_send_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_send_bench.o -lpthread
+
+echo ---------- compiling checksum_throughput_bench.cpp
+g++ -O2 -g -c -Wall checksum_throughput_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o checksum_throughput_bench \
+	checksum_bench.o checksum_throughput_bench.o
+
+echo ---------- compiling link_layer_batch_bench.cpp
+g++ -O2 -g -c -Wall link_layer_batch_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_batch_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_batch_bench.o -lpthread
+
+echo ---------- compiling link_layer_window_bench.cpp
+g++ -O2 -g -c -Wall link_layer_window_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_window_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_window_bench.o -lpthread
+
+echo ---------- compiling link_layer_sim_bench.cpp
+g++ -O2 -g -c -Wall link_layer_sim_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_sim_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_sim_bench.o -lpthread
+
+echo ---------- compiling network_layer.cpp
+g++ -O2 -g -c -Wall -o network_layer_bench_lib.o network_layer.cpp
+
+echo ---------- compiling network_layer_bench.cpp
+g++ -O2 -g -c -Wall network_layer_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o network_layer_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o network_layer_bench_lib.o network_layer_bench.o \
+	-lpthread
+
+echo ---------- compiling link_layer_rto_bench.cpp
+g++ -O2 -g -c -Wall link_layer_rto_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_rto_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_rto_bench.o -lpthread
+
+echo ---------- compiling link_layer_cwnd_bench.cpp
+g++ -O2 -g -c -Wall link_layer_cwnd_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_cwnd_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_cwnd_bench.o -lpthread
+
+echo ---------- compiling link_layer_ack_bench.cpp
+g++ -O2 -g -c -Wall link_layer_ack_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_ack_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_ack_bench.o -lpthread
+
+echo ---------- compiling message_layer.cpp
+g++ -O2 -g -c -Wall -o message_layer_bench_lib.o message_layer.cpp
+
+echo ---------- compiling message_layer_bench.cpp
+g++ -O2 -g -c -Wall message_layer_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o message_layer_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o message_layer_bench_lib.o message_layer_bench.o \
+	-lpthread
+
+echo ---------- compiling link_layer_mtu_bench.cpp
+g++ -O2 -g -c -Wall link_layer_mtu_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_mtu_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_mtu_bench.o -lpthread
+
+echo ---------- compiling link_layer_suite_bench.cpp
+g++ -O2 -g -c -Wall link_layer_suite_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_suite_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_suite_bench.o -lpthread
+
+echo ---------- compiling trace.cpp
+g++ -O2 -g -c -Wall -o trace_bench_lib.o trace.cpp
+
+echo ---------- compiling link_layer_trace_bench.cpp
+g++ -O2 -g -c -Wall link_layer_trace_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_trace_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o trace_bench_lib.o link_layer_trace_bench.o \
+	-lpthread
+
+echo ---------- compiling link_layer_impair_bench.cpp
+g++ -O2 -g -c -Wall link_layer_impair_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_impair_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_impair_bench.o -lpthread
+
+echo ---------- compiling replay.cpp
+g++ -O2 -g -c -Wall -o replay_bench_lib.o replay.cpp
+
+echo ---------- compiling link_layer_replay_bench.cpp
+g++ -O2 -g -c -Wall link_layer_replay_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_replay_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o replay_bench_lib.o link_layer_replay_bench.o \
+	-lpthread
+
+echo ---------- compiling thread_pool.cpp
+g++ -O2 -g -c -Wall -o thread_pool_bench_lib.o thread_pool.cpp
+
+echo ---------- compiling link_layer_sweep.cpp
+g++ -O2 -g -c -Wall link_layer_sweep.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_sweep \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o thread_pool_bench_lib.o link_layer_sweep.o \
+	-lpthread
+
+echo ---------- compiling link_layer_reactor_bench.cpp
+g++ -O2 -g -c -Wall link_layer_reactor_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_reactor_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o link_layer_reactor_bench.o -lpthread
+
+echo ---------- compiling async_link.cpp
+g++ -std=c++20 -O2 -g -c -Wall -o async_link_bench_lib.o async_link.cpp
+
+echo ---------- compiling link_layer_async_bench.cpp
+g++ -std=c++20 -O2 -g -c -Wall link_layer_async_bench.cpp
+
+echo ---------- linking
+g++ -O2 -g -o link_layer_async_bench \
+	physical_layer_bench.o checksum_bench.o simulator_bench.o reactor_bench.o \
+	link_layer_bench.o thread_pool_bench_lib.o async_link_bench_lib.o \
+	link_layer_async_bench.o -lpthread
@@ -1,6 +1,15 @@
 echo ---------- compiling physical_layer.cpp
 g++ -g -c -Wall physical_layer.cpp
 
+echo ---------- compiling checksum.cpp
+g++ -g -c -Wall checksum.cpp
+
+echo ---------- compiling simulator.cpp
+g++ -g -c -Wall simulator.cpp
+
+echo ---------- compiling reactor.cpp
+g++ -g -c -Wall reactor.cpp
+
 echo ---------- compiling link_layer.cpp
 g++ -g -c -Wall link_layer.cpp
 
@@ -9,4 +18,5 @@ g++ -g -c -Wall link_layer_test.cpp
 
 echo ---------- linking
 g++ -g -o link_layer_test \
-	physical_layer.o link_layer.o link_layer_test.o -lpthread
+	physical_layer.o checksum.o simulator.o reactor.o link_layer.o \
+	link_layer_test.o -lpthread
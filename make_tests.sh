@@ -0,0 +1,96 @@
+echo ---------- compiling physical_layer.cpp
+g++ -g -c -Wall physical_layer.cpp
+
+echo ---------- compiling checksum.cpp
+g++ -g -c -Wall checksum.cpp
+
+echo ---------- compiling simulator.cpp
+g++ -g -c -Wall simulator.cpp
+
+echo ---------- compiling reactor.cpp
+g++ -g -c -Wall reactor.cpp
+
+echo ---------- compiling link_layer.cpp
+g++ -g -c -Wall link_layer.cpp
+
+echo ---------- compiling link_layer_rto_test.cpp
+g++ -g -c -Wall link_layer_rto_test.cpp
+
+echo ---------- linking
+g++ -g -o link_layer_rto_test \
+	physical_layer.o checksum.o simulator.o reactor.o link_layer.o \
+	link_layer_rto_test.o -lpthread
+
+echo ---------- compiling link_layer_sr_test.cpp
+g++ -g -c -Wall link_layer_sr_test.cpp
+
+echo ---------- linking
+g++ -g -o link_layer_sr_test \
+	physical_layer.o checksum.o simulator.o reactor.o link_layer.o \
+	link_layer_sr_test.o -lpthread
+
+echo ---------- compiling spsc_ring_test.cpp
+g++ -g -c -Wall spsc_ring_test.cpp
+
+echo ---------- linking
+g++ -g -o spsc_ring_test spsc_ring_test.o -lpthread
+
+echo ---------- compiling link_layer_timer_test.cpp
+g++ -g -c -Wall link_layer_timer_test.cpp
+
+echo ---------- linking
+g++ -g -o link_layer_timer_test \
+	physical_layer.o checksum.o simulator.o reactor.o link_layer.o \
+	link_layer_timer_test.o -lpthread
+
+echo ---------- compiling network_layer.cpp
+g++ -g -c -Wall network_layer.cpp
+
+echo ---------- compiling network_layer_test.cpp
+g++ -g -c -Wall network_layer_test.cpp
+
+echo ---------- linking
+g++ -g -o network_layer_test \
+	physical_layer.o checksum.o simulator.o reactor.o link_layer.o \
+	network_layer.o network_layer_test.o -lpthread
+
+echo ---------- compiling message_layer.cpp
+g++ -g -c -Wall message_layer.cpp
+
+echo ---------- compiling message_layer_test.cpp
+g++ -g -c -Wall message_layer_test.cpp
+
+echo ---------- linking
+g++ -g -o message_layer_test \
+	physical_layer.o checksum.o simulator.o reactor.o link_layer.o \
+	message_layer.o message_layer_test.o -lpthread
+
+echo ---------- compiling replay.cpp
+g++ -g -c -Wall replay.cpp
+
+echo ---------- compiling replay_test.cpp
+g++ -g -c -Wall replay_test.cpp
+
+echo ---------- linking
+g++ -g -o replay_test \
+	physical_layer.o checksum.o simulator.o replay.o replay_test.o
+
+echo ---------- compiling reactor_test.cpp
+g++ -g -c -Wall reactor_test.cpp
+
+echo ---------- linking
+g++ -g -o reactor_test reactor.o reactor_test.o -lpthread
+
+echo ---------- compiling thread_pool.cpp
+g++ -g -c -Wall thread_pool.cpp
+
+echo ---------- compiling async_link.cpp
+g++ -std=c++20 -g -c -Wall async_link.cpp
+
+echo ---------- compiling async_link_test.cpp
+g++ -std=c++20 -g -c -Wall async_link_test.cpp
+
+echo ---------- linking
+g++ -g -o async_link_test \
+	physical_layer.o checksum.o simulator.o reactor.o link_layer.o \
+	thread_pool.o async_link.o async_link_test.o -lpthread
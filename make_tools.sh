@@ -0,0 +1,4 @@
+echo ---------- compiling trace_to_pcap.cpp
+g++ -O2 -g -Wall -o trace_to_pcap trace_to_pcap.cpp
+echo ---------- compiling csv_to_replay.cpp
+g++ -O2 -g -Wall -o csv_to_replay csv_to_replay.cpp
@@ -0,0 +1,226 @@
+#include <string.h>
+
+#include "message_layer.h"
+
+using namespace std;
+
+// Message_pool -----------------------------------------------------------
+
+Message_pool::Message_pool(unsigned int num_buffers,
+ unsigned int buffer_length0)
+	: storage((size_t) num_buffers*buffer_length0)
+{
+	buffer_length = buffer_length0;
+	free_buffers.reserve(num_buffers);
+	for (unsigned int i = num_buffers; i-- > 0;) {
+		free_buffers.push_back(&storage[(size_t) i*buffer_length]);
+	}
+}
+
+unsigned char* Message_pool::get(void)
+{
+	if (free_buffers.empty()) {
+		return NULL;
+	}
+	unsigned char* buffer = free_buffers.back();
+	free_buffers.pop_back();
+	return buffer;
+}
+
+// reserve made room for every buffer, so this never allocates
+void Message_pool::put(unsigned char* buffer)
+{
+	free_buffers.push_back(buffer);
+}
+
+unsigned int Message_pool::get_buffer_length(void)
+{
+	return buffer_length;
+}
+
+unsigned int Message_pool::get_num_free(void)
+{
+	return free_buffers.size();
+}
+
+// Message_layer ----------------------------------------------------------
+
+// the last frame of a message is written at a full frame's stride before
+// its length is checked, so every buffer has a frame to spare
+Message_layer::Message_layer(Link_layer* link_layer0,
+ unsigned int maximum_message_length0,unsigned int pool_size)
+	: send_pool(pool_size,LENGTH_PREFIX+maximum_message_length0),
+	  sending(pool_size),
+	  receive_pool(pool_size,LENGTH_PREFIX+maximum_message_length0
+	   +Link_layer::MAXIMUM_DATA_LENGTH),
+	  received(pool_size)
+{
+	if (maximum_message_length0 == 0 || pool_size == 0) {
+		throw Message_exception();
+	}
+	link_layer = link_layer0;
+	maximum_message_length = maximum_message_length0;
+	num_sending = 0;
+	assembling.data = NULL;
+}
+
+unsigned int Message_layer::send(unsigned char buffer[],unsigned int length)
+{
+	if (length == 0 || length > maximum_message_length) {
+		throw Message_exception();
+	}
+	flush();
+
+	unsigned char* data = send_pool.get();
+	if (data == NULL) {
+		return 0;
+	}
+	// the pool holds pool_size buffers and sending has room for as many
+	Message_buffer* slot = sending.back();
+	memcpy(data,&length,LENGTH_PREFIX);
+	memcpy(data+LENGTH_PREFIX,buffer,length);
+	slot->data = data;
+	slot->length = LENGTH_PREFIX+length;
+	slot->offset = 0;
+	sending.push();
+	num_sending++;
+
+	flush();
+	return length;
+}
+
+// prefix and data are one byte run, cut into full frames but the last,
+// so consecutive frames are consecutive send_many strides
+unsigned int Message_layer::flush(void)
+{
+	unsigned int length[FRAME_BATCH];
+	Message_buffer* m;
+
+	while ((m = sending.front()) != NULL) {
+		while (m->offset < m->length) {
+			unsigned int remaining = m->length-m->offset;
+			unsigned int n = 0;
+			while (n < FRAME_BATCH && remaining > 0) {
+				length[n] = remaining < Link_layer::MAXIMUM_DATA_LENGTH
+				 ? remaining : (unsigned int) Link_layer::MAXIMUM_DATA_LENGTH;
+				remaining -= length[n];
+				n++;
+			}
+			unsigned int sent = link_layer->send_many(m->data+m->offset,
+			 length,n);
+			for (unsigned int i = 0; i < sent; i++) {
+				m->offset += length[i];
+			}
+			if (sent < n) {
+				return num_sending;
+			}
+		}
+		send_pool.put(m->data);
+		sending.pop();
+		num_sending--;
+	}
+	return num_sending;
+}
+
+// move delivered frames into pool buffers, completing as many messages as
+// there are free buffers for; frames left in the link hold back its
+// window until receive frees one
+void Message_layer::reassemble(void)
+{
+	unsigned int length[FRAME_BATCH];
+
+	while (true) {
+		if (assembling.data == NULL) {
+			unsigned int frame_length;
+			const unsigned char* frame = link_layer->receive_loan(frame_length);
+			if (frame == NULL) {
+				return;
+			}
+			unsigned int message_length;
+			if (frame_length < LENGTH_PREFIX) {
+				throw Message_exception();
+			}
+			memcpy(&message_length,frame,LENGTH_PREFIX);
+			if (message_length == 0
+			 || message_length > maximum_message_length
+			 || frame_length != (LENGTH_PREFIX+message_length
+			  < Link_layer::MAXIMUM_DATA_LENGTH
+			  ? LENGTH_PREFIX+message_length
+			  : (unsigned int) Link_layer::MAXIMUM_DATA_LENGTH)) {
+				throw Message_exception();
+			}
+			unsigned char* data = receive_pool.get();
+			if (data == NULL) {
+				return;
+			}
+			memcpy(data,frame,frame_length);
+			link_layer->receive_release();
+			assembling.data = data;
+			assembling.length = LENGTH_PREFIX+message_length;
+			assembling.offset = frame_length;
+		}
+
+		while (assembling.offset < assembling.length) {
+			unsigned int remaining = assembling.length-assembling.offset;
+			unsigned int frames = (remaining+Link_layer::MAXIMUM_DATA_LENGTH-1)
+			 /Link_layer::MAXIMUM_DATA_LENGTH;
+			unsigned int n = link_layer->receive_many(
+			 assembling.data+assembling.offset,length,
+			 frames < FRAME_BATCH ? frames : (unsigned int) FRAME_BATCH);
+			if (n == 0) {
+				return;
+			}
+			for (unsigned int i = 0; i < n; i++) {
+				remaining = assembling.length-assembling.offset;
+				if (length[i] != (remaining < Link_layer::MAXIMUM_DATA_LENGTH
+				 ? remaining : (unsigned int) Link_layer::MAXIMUM_DATA_LENGTH)) {
+					throw Message_exception();
+				}
+				assembling.offset += length[i];
+			}
+		}
+
+		// the pool holds pool_size buffers and received has room for as many
+		*received.back() = assembling;
+		received.push();
+		assembling.data = NULL;
+	}
+}
+
+unsigned int Message_layer::receive(unsigned char buffer[])
+{
+	unsigned int length;
+	const unsigned char* data = receive_loan(length);
+	if (data == NULL) {
+		return 0;
+	}
+	memcpy(buffer,data,length);
+	receive_release();
+	return length;
+}
+
+const unsigned char* Message_layer::receive_loan(unsigned int& length)
+{
+	reassemble();
+	Message_buffer* m = received.front();
+	if (m == NULL) {
+		return NULL;
+	}
+	length = m->length-LENGTH_PREFIX;
+	return m->data+LENGTH_PREFIX;
+}
+
+void Message_layer::receive_release(void)
+{
+	Message_buffer* m = received.front();
+	if (m == NULL) {
+		throw Message_exception();
+	}
+	receive_pool.put(m->data);
+	received.pop();
+}
+
+unsigned int Message_layer::get_maximum_message_length(void)
+{
+	return maximum_message_length;
+}
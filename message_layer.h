@@ -0,0 +1,106 @@
+#include <exception>
+#include <vector>
+
+#include "link_layer.h"
+#include "spsc_ring.h"
+
+#ifndef MESSAGE_LAYER_H
+#define MESSAGE_LAYER_H
+
+using namespace std;
+
+// Message_exception ------------------------------------------------------
+
+class Message_exception: public exception {
+};
+
+// Message_pool -----------------------------------------------------------
+
+// num_buffers buffers of buffer_length bytes, allocated once; get and put
+// never allocate
+class Message_pool {
+public:
+	Message_pool(unsigned int num_buffers,unsigned int buffer_length);
+
+	// a free buffer, or NULL if all are taken
+	unsigned char* get(void);
+	void put(unsigned char* buffer);
+
+	unsigned int get_buffer_length(void);
+	unsigned int get_num_free(void);
+private:
+	Message_pool(const Message_pool&);
+	Message_pool& operator=(const Message_pool&);
+
+	vector<unsigned char> storage;
+	vector<unsigned char*> free_buffers;
+	unsigned int buffer_length;
+};
+
+// a message in a pool buffer: its length prefix, then its data
+struct Message_buffer {
+	unsigned char* data;
+	unsigned int length; // prefix and data
+	unsigned int offset; // bytes handed to or taken from the link so far
+};
+
+// Message_layer ----------------------------------------------------------
+
+// Messages of up to maximum_message_length bytes over a Link_layer. A
+// message goes out as a run of frames: the first starts with its length,
+// and every frame but the last is full. The link delivers frames in
+// order, so the receiver needs nothing more to find where each message
+// ends. Fragmentation and reassembly run on the calling threads, through
+// preallocated pool buffers; one thread may send while another receives.
+// The peer must be a Message_layer with the same maximum_message_length,
+// and nothing else may send or receive on either link
+class Message_layer {
+public:
+	enum {LENGTH_PREFIX = sizeof(unsigned int)};
+	enum {FRAME_BATCH = 32}; // most frames per send_many or receive_many
+
+	// pool_size buffers of maximum_message_length bytes each way
+	Message_layer(Link_layer* link_layer,
+	 unsigned int maximum_message_length,unsigned int pool_size);
+
+	// copy length bytes from buffer to a pool buffer and start sending
+	// them; return 0 if every send buffer is taken
+	unsigned int send(unsigned char buffer[],unsigned int length);
+
+	// hand queued fragments to the link as its send ring frees up; send
+	// does this too. Return the number of messages not yet fully handed
+	// over
+	unsigned int flush(void);
+
+	// copy the oldest complete message to buffer and return its length,
+	// or return 0 if there is none
+	unsigned int receive(unsigned char buffer[]);
+
+	// zero-copy receive: borrow the oldest complete message, or NULL if
+	// there is none, and give it back with receive_release
+	const unsigned char* receive_loan(unsigned int& length);
+	void receive_release(void);
+
+	unsigned int get_maximum_message_length(void);
+private:
+	Message_layer(const Message_layer&);
+	Message_layer& operator=(const Message_layer&);
+
+	void reassemble(void);
+
+	Link_layer* link_layer;
+	unsigned int maximum_message_length;
+
+	// sender: messages waiting for the link, the front one partly sent
+	Message_pool send_pool;
+	Spsc_ring<Message_buffer> sending;
+	unsigned int num_sending;
+
+	// receiver: the message being reassembled, if assembling.data is not
+	// NULL, and complete messages waiting for receive
+	Message_pool receive_pool;
+	Message_buffer assembling;
+	Spsc_ring<Message_buffer> received;
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include <string.h>
+
+#include "message_layer.h"
+#include "timeval_operators.h"
+
+using namespace std;
+
+// Message benchmark: sends the same number of bytes a -> b as messages of
+// 1 KB to 1 MB over an unimpaired Physical_layer, fragmented and
+// reassembled by Message_layer, and reports the goodput and message rate
+// for each size. Every message is checked on arrival.
+
+const unsigned int NUM_SEQ = 1024;
+const unsigned int MAX_WIN = 256;
+const unsigned int TIMEOUT = 100000;
+const unsigned int MAXIMUM_MESSAGE_LENGTH = 1 << 20;
+const unsigned int POOL_SIZE = 4;
+
+void fill(unsigned char buffer[],unsigned int length,unsigned int n)
+{
+	memset(buffer,(unsigned char) n,length);
+	memcpy(buffer,&n,sizeof(n));
+}
+
+void run(unsigned int length,unsigned long total,unsigned char send_buffer[],
+ unsigned char receive_buffer[])
+{
+	Impair impair(NULL,0,NULL,0,0);
+	Physical_layer physical_layer(impair,impair,NULL,NULL);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::GO_BACK_N,2*MAX_WIN);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,Link_layer::GO_BACK_N,2*MAX_WIN);
+	Message_layer a_message_layer(&a_link_layer,MAXIMUM_MESSAGE_LENGTH,
+	 POOL_SIZE);
+	Message_layer b_message_layer(&b_link_layer,MAXIMUM_MESSAGE_LENGTH,
+	 POOL_SIZE);
+
+	unsigned int messages = (total+length-1)/length;
+	unsigned int send_count = 0;
+	unsigned int receive_count = 0;
+
+	struct timeval start,stop;
+	gettimeofday(&start,NULL);
+	fill(send_buffer,length,send_count);
+	while (receive_count < messages) {
+		bool idle = true;
+		if (send_count < messages) {
+			if (a_message_layer.send(send_buffer,length) > 0) {
+				send_count++;
+				fill(send_buffer,length,send_count);
+				idle = false;
+			}
+		} else if (a_message_layer.flush() > 0) {
+			idle = false;
+		}
+		unsigned int n = b_message_layer.receive(receive_buffer);
+		if (n > 0) {
+			unsigned int k;
+			memcpy(&k,receive_buffer,sizeof(k));
+			if (n != length || k != receive_count
+			 || receive_buffer[n-1] != (unsigned char) receive_count) {
+				cout << "bad message " << receive_count << endl;
+				exit(1);
+			}
+			receive_count++;
+			idle = false;
+		}
+		// leave the core to the protocol threads while they catch up
+		if (idle) {
+			usleep(10);
+		}
+	}
+	gettimeofday(&stop,NULL);
+
+	struct timeval elapsed = stop-start;
+	double seconds = elapsed.tv_sec+elapsed.tv_usec/1000000.0;
+	unsigned int frames = (Message_layer::LENGTH_PREFIX+length
+	 +Link_layer::MAXIMUM_DATA_LENGTH-1)/Link_layer::MAXIMUM_DATA_LENGTH;
+	cout << length << "\t" << messages << "\t" << frames
+	 << "\t" << fixed << setprecision(2)
+	 << (double) messages*length/seconds/1000000
+	 << "\t" << setprecision(0) << messages/seconds << endl;
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 2) {
+		cout << "Syntax: " << argv[0] << " megabytes" << endl;
+		exit(1);
+	}
+	unsigned long total = atof(argv[1])*1000000;
+
+	unsigned char* send_buffer = new unsigned char[MAXIMUM_MESSAGE_LENGTH];
+	unsigned char* receive_buffer = new unsigned char[MAXIMUM_MESSAGE_LENGTH];
+
+	cout << "bytes\tmessages\tframes/message\tMB/s\tmessages/s" << endl;
+	for (unsigned int length = 1024; length <= MAXIMUM_MESSAGE_LENGTH;
+	 length *= 4) {
+		run(length,total,send_buffer,receive_buffer);
+	}
+
+	delete[] send_buffer;
+	delete[] receive_buffer;
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <stdlib.h>
+
+#include "message_layer.h"
+#include "simulator.h"
+
+using namespace std;
+
+// Message test: messages of every length from 1 byte to MAXIMUM_LENGTH,
+// which takes up to five frames, go a -> b twice over on a Simulator
+// whose path drops, reorders and duplicates frames. Each must be
+// reassembled whole and in order, taken alternately by receive and by
+// receive_loan, with selective repeat and with go-back-N.
+
+const unsigned int NUM_SEQ = 16;
+const unsigned int MAX_WIN = 4;
+const unsigned int TIMEOUT = 20000;
+const unsigned int DELAY = 2000; // microseconds each way
+const unsigned int BANDWIDTH = 1000000; // bits per second
+const unsigned int MAXIMUM_LENGTH = 4*Link_layer::MAXIMUM_DATA_LENGTH;
+const unsigned int POOL_SIZE = 3;
+const unsigned int MESSAGES = 2*MAXIMUM_LENGTH;
+// seconds of virtual time; a stuck receiver keeps the sender probing
+const unsigned int TIME_LIMIT = 60;
+
+// message n is n % MAXIMUM_LENGTH + 1 bytes long, each depending on n
+unsigned int length_of(unsigned int n)
+{
+	return n % MAXIMUM_LENGTH + 1;
+}
+
+unsigned char byte_of(unsigned int n,unsigned int i)
+{
+	return n*7+i;
+}
+
+bool run(Link_layer::Arq_mode arq_mode,const char* name)
+{
+	Simulator simulator;
+	double drop[] = {0.1};
+	Impair impair(drop,1,NULL,0,DELAY,5);
+	if (arq_mode == Link_layer::SELECTIVE_REPEAT) {
+		impair.set_reorder(0.1);
+		impair.set_duplicate(0.05);
+	}
+	Physical_layer physical_layer(impair,impair,NULL,NULL,
+	 2*MAX_WIN,BANDWIDTH,&simulator);
+	Link_layer a_link_layer(physical_layer.get_a_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,arq_mode);
+	Link_layer b_link_layer(physical_layer.get_b_interface(),
+	 NUM_SEQ,MAX_WIN,TIMEOUT,arq_mode);
+	Message_layer a_message_layer(&a_link_layer,MAXIMUM_LENGTH,POOL_SIZE);
+	Message_layer b_message_layer(&b_link_layer,MAXIMUM_LENGTH,POOL_SIZE);
+
+	unsigned char buffer[MAXIMUM_LENGTH];
+	unsigned int sent = 0;
+	unsigned int received = 0;
+	while (received < MESSAGES) {
+		while (sent < MESSAGES) {
+			for (unsigned int i = 0; i < length_of(sent); i++) {
+				buffer[i] = byte_of(sent,i);
+			}
+			if (a_message_layer.send(buffer,length_of(sent)) == 0) {
+				break;
+			}
+			sent++;
+		}
+		a_message_layer.flush();
+
+		while (true) {
+			const unsigned char* message;
+			unsigned int length = 0;
+			if (received % 2 == 0) {
+				length = b_message_layer.receive(buffer);
+				message = buffer;
+			} else {
+				message = b_message_layer.receive_loan(length);
+			}
+			if (length == 0 || message == NULL) {
+				break;
+			}
+			bool same = length == length_of(received);
+			for (unsigned int i = 0; same && i < length; i++) {
+				same = message[i] == byte_of(received,i);
+			}
+			if (!same) {
+				cout << "FAIL: " << name << " message "
+				 << received << " of " << length
+				 << " bytes is not whole" << endl;
+				return false;
+			}
+			if (received % 2 != 0) {
+				b_message_layer.receive_release();
+			}
+			received++;
+		}
+		if (received < MESSAGES && (!simulator.step()
+		 || simulator.now().tv_sec >= TIME_LIMIT)) {
+			cout << "FAIL: " << name << " stalled after "
+			 << received << " messages" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc,char* argv[])
+{
+	if (!run(Link_layer::SELECTIVE_REPEAT,"selective repeat")
+	 || !run(Link_layer::GO_BACK_N,"go-back-N")) {
+		return 1;
+	}
+	cout << "ok" << endl;
+	return 0;
+}
@@ -0,0 +1,107 @@
+#include <atomic>
+
+#ifndef METRICS_H
+#define METRICS_H
+
+// Counter ----------------------------------------------------------------
+
+// A count kept on a hot path and read from anywhere. Writers take turns -
+// every counter here is written under its owner's lock - so add is a
+// relaxed load and store, with no locked instruction. Any thread may get
+// it at any time, without the lock; it sees a value the counter had,
+// though not necessarily in step with other counters
+class Counter {
+public:
+	Counter()
+	{
+		value.store(0,std::memory_order_relaxed);
+	}
+
+	void add(unsigned long n = 1)
+	{
+		value.store(value.load(std::memory_order_relaxed)+n,
+		 std::memory_order_relaxed);
+	}
+
+	unsigned long get() const
+	{
+		return value.load(std::memory_order_relaxed);
+	}
+private:
+	Counter(const Counter&);
+	Counter& operator=(const Counter&);
+
+	std::atomic<unsigned long> value;
+};
+
+// Histogram_snapshot -----------------------------------------------------
+
+// bucket 0 counts zeros and bucket i > 0 values in [2^(i-1),2^i); the
+// last bucket also takes everything larger
+struct Histogram_snapshot {
+	enum {NUM_BUCKETS = 33};
+
+	unsigned long buckets[NUM_BUCKETS];
+	unsigned long sum; // of the values recorded
+
+	unsigned long count() const
+	{
+		unsigned long n = 0;
+		for (unsigned int i = 0; i < NUM_BUCKETS; i++) {
+			n += buckets[i];
+		}
+		return n;
+	}
+
+	// upper bound of the bucket holding the p-th fraction of the values,
+	// 0 < p <= 1, or 0 if none were recorded
+	unsigned long percentile(double p) const
+	{
+		unsigned long n = count();
+		unsigned long rank = (unsigned long) (p*n);
+		if (rank < p*n || rank == 0) {
+			rank++;
+		}
+		unsigned long seen = 0;
+		for (unsigned int i = 0; i < NUM_BUCKETS && n > 0; i++) {
+			seen += buckets[i];
+			if (seen >= rank) {
+				return i == 0 ? 0 : (1ul << i)-1;
+			}
+		}
+		return 0;
+	}
+};
+
+// Histogram --------------------------------------------------------------
+
+// log2 buckets of Counters, with the same rules: one writer at a time,
+// readers anywhere
+class Histogram {
+public:
+	void record(unsigned long value)
+	{
+		unsigned int i = value == 0 ? 0
+		 : 8*sizeof(unsigned long)-__builtin_clzl(value);
+		if (i >= Histogram_snapshot::NUM_BUCKETS) {
+			i = Histogram_snapshot::NUM_BUCKETS-1;
+		}
+		buckets[i].add();
+		sum.add(value);
+	}
+
+	Histogram_snapshot get() const
+	{
+		Histogram_snapshot snapshot;
+		for (unsigned int i = 0; i < Histogram_snapshot::NUM_BUCKETS; i++) {
+			snapshot.buckets[i] = buckets[i].get();
+		}
+		snapshot.sum = sum.get();
+		return snapshot;
+	}
+private:
+	Counter buckets[Histogram_snapshot::NUM_BUCKETS];
+	Counter sum;
+};
+
+#endif
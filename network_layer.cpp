@@ -0,0 +1,451 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "network_layer.h"
+
+using namespace std;
+
+// Link_config ------------------------------------------------------------
+
+Link_config::Link_config()
+	: impair(NULL,0,NULL,0,0)
+{
+	queue_depth = 1;
+	bandwidth = 0;
+	num_sequence_numbers = 8;
+	max_send_window_size = 4;
+	timeout = 20000;
+	arq_mode = Link_layer::GO_BACK_N;
+}
+
+// Network_node -----------------------------------------------------------
+
+Network_node::Network_node(Network* network0,unsigned int id0)
+	: received(QUEUE_LENGTH),event(&Network_node::run_event,this)
+{
+	network = network0;
+	id = id0;
+
+	listener = NULL;
+	listener_arg = NULL;
+
+	pending = false;
+
+	forwarded = 0;
+	delivered = 0;
+	dropped = 0;
+}
+
+Network_node::~Network_node()
+{
+	if (network->get_simulator() != NULL) {
+		network->get_simulator()->cancel_timer(event);
+	}
+}
+
+unsigned int Network_node::get_id(void)
+{
+	return id;
+}
+
+unsigned int Network_node::send(unsigned int destination,
+ unsigned char buffer[],unsigned int length)
+{
+	if (length == 0 || length > MAXIMUM_DATA_LENGTH
+	 || destination >= network->get_num_nodes()) {
+		throw Network_exception();
+	}
+
+	// build the frame in place: straight in the link's send ring if
+	// nothing is queued ahead of it, else at the back of the port queue
+	unsigned char* frame;
+	Port* port = NULL;
+	Network_frame* slot = NULL;
+	if (destination == id) {
+		if ((slot = received.back()) == NULL) {
+			return 0;
+		}
+		frame = slot->data;
+	} else {
+		if (destination >= routes.size()
+		 || routes[destination] == NO_ROUTE) {
+			throw Network_exception();
+		}
+		port = &ports[routes[destination]];
+		if (!port->queue->empty()
+		 || (frame = port->link->send_loan()) == NULL) {
+			if ((slot = port->queue->back()) == NULL) {
+				return 0;
+			}
+			frame = slot->data;
+		}
+	}
+
+	Network_header header;
+	header.source = id;
+	header.destination = destination;
+	header.ttl = DEFAULT_TTL;
+	memcpy(frame,&header,sizeof(header));
+	memcpy(frame+sizeof(header),buffer,length);
+
+	if (slot == NULL) {
+		port->link->send_commit(sizeof(header)+length);
+	} else if (port == NULL) {
+		slot->length = sizeof(header)+length;
+		received.push();
+		delivered++;
+		if (listener != NULL) {
+			listener(listener_arg);
+		}
+	} else {
+		slot->length = sizeof(header)+length;
+		port->queue->push();
+	}
+	return length;
+}
+
+unsigned int Network_node::receive(unsigned char buffer[],
+ unsigned int& source)
+{
+	Network_frame* slot = received.front();
+	if (slot == NULL) {
+		return 0;
+	}
+
+	Network_header header;
+	memcpy(&header,slot->data,sizeof(header));
+	unsigned int length = slot->length-sizeof(header);
+	memcpy(buffer,slot->data+sizeof(header),length);
+	source = header.source;
+
+	received.pop();
+	return length;
+}
+
+void Network_node::set_listener(void (*listener0)(void*),
+ void* listener_arg0)
+{
+	listener = listener0;
+	listener_arg = listener_arg0;
+}
+
+unsigned long Network_node::get_forwarded(void)
+{
+	return forwarded;
+}
+
+unsigned long Network_node::get_delivered(void)
+{
+	return delivered;
+}
+
+unsigned long Network_node::get_dropped(void)
+{
+	return dropped;
+}
+
+// Link_layer listener: a link delivered frames or has room to send.
+// In real time this runs on the link's thread, so only flag the node
+void Network_node::wakeup(void* node0)
+{
+	Network_node* node = (Network_node*) node0;
+	Simulator* simulator = node->network->get_simulator();
+
+	node->pending.store(true,std::memory_order_release);
+	if (simulator != NULL && !node->event.is_scheduled()) {
+		simulator->set_timer(node->event,simulator->now());
+	}
+}
+
+void Network_node::run_event(void* node0)
+{
+	((Network_node*) node0)->process();
+}
+
+// route every frame the links delivered, then move queued frames into
+// links with room
+void Network_node::process(void)
+{
+	// cleared first, so a wakeup while we run is not lost
+	pending.store(false,std::memory_order_relaxed);
+
+	for (unsigned int i = 0; i < ports.size(); i++) {
+		Link_layer* link = ports[i].link.get();
+		const unsigned char* frame;
+		unsigned int length;
+		while ((frame = link->receive_loan(length)) != NULL) {
+			if (length >= sizeof(Network_header)) {
+				route(frame,length);
+			} else {
+				dropped++;
+			}
+			link->receive_release();
+		}
+	}
+	for (unsigned int i = 0; i < ports.size(); i++) {
+		flush(ports[i]);
+	}
+}
+
+// deliver a received frame here or pass it on toward its destination;
+// frames with nowhere to go are dropped
+void Network_node::route(const unsigned char frame[],unsigned int length)
+{
+	Network_header header;
+	memcpy(&header,frame,sizeof(header));
+
+	if (header.destination == id) {
+		Network_frame* slot = received.back();
+		if (slot == NULL) {
+			dropped++;
+			return;
+		}
+		memcpy(slot->data,frame,length);
+		slot->length = length;
+		received.push();
+		delivered++;
+		if (listener != NULL) {
+			listener(listener_arg);
+		}
+		return;
+	}
+
+	if (header.destination >= routes.size()
+	 || routes[header.destination] == NO_ROUTE || header.ttl == 0) {
+		dropped++;
+		return;
+	}
+	header.ttl--;
+
+	// straight into the next link when nothing is queued ahead of it
+	Port& port = ports[routes[header.destination]];
+	unsigned char* data;
+	if (port.queue->empty() && (data = port.link->send_loan()) != NULL) {
+		memcpy(data,&header,sizeof(header));
+		memcpy(data+sizeof(header),frame+sizeof(header),
+		 length-sizeof(header));
+		port.link->send_commit(length);
+	} else {
+		Network_frame* slot = port.queue->back();
+		if (slot == NULL) {
+			dropped++;
+			return;
+		}
+		memcpy(slot->data,&header,sizeof(header));
+		memcpy(slot->data+sizeof(header),frame+sizeof(header),
+		 length-sizeof(header));
+		slot->length = length;
+		port.queue->push();
+	}
+	forwarded++;
+}
+
+void Network_node::flush(Port& port)
+{
+	Network_frame* slot;
+	unsigned char* data;
+	while ((slot = port.queue->front()) != NULL
+	 && (data = port.link->send_loan()) != NULL) {
+		memcpy(data,slot->data,slot->length);
+		port.link->send_commit(slot->length);
+		port.queue->pop();
+	}
+}
+
+// Network ----------------------------------------------------------------
+
+Network::Network(unsigned int num_nodes,const Link_config& config0,
+ Simulator* simulator0)
+	: config(config0)
+{
+	if (num_nodes == 0 || num_nodes > MAXIMUM_NODES) {
+		throw Network_exception();
+	}
+
+	simulator = simulator0;
+	nodes.resize(num_nodes);
+	for (unsigned int i = 0; i < num_nodes; i++) {
+		nodes[i] = new Network_node(this,i);
+	}
+}
+
+Network::~Network()
+{
+	// links first: they call back into nodes and use the physical layers
+	for (unsigned int i = 0; i < nodes.size(); i++) {
+		for (unsigned int j = 0; j < nodes[i]->ports.size(); j++) {
+			nodes[i]->ports[j].link.reset();
+		}
+	}
+	physical_layers.clear();
+	for (unsigned int i = 0; i < nodes.size(); i++) {
+		delete nodes[i];
+	}
+}
+
+unsigned int Network::add_link(unsigned int node0,unsigned int node1)
+{
+	if (node0 >= nodes.size() || node1 >= nodes.size() || node0 == node1
+	 || nodes[node0]->ports.size() >= Network_node::MAXIMUM_PORTS
+	 || nodes[node1]->ports.size() >= Network_node::MAXIMUM_PORTS) {
+		throw Network_exception();
+	}
+
+	// build the link aside: if anything throws, what was built is freed,
+	// links before their physical layer, and the network is unchanged
+	unique_ptr<Physical_layer> physical_layer(new Physical_layer(
+	 config.impair,config.impair,NULL,NULL,
+	 config.queue_depth,config.bandwidth,simulator));
+
+	Physical_layer_interface* interfaces[2] = {
+	 physical_layer->get_a_interface(),physical_layer->get_b_interface()};
+	Network_node* ends[2] = {nodes[node0],nodes[node1]};
+	Network_node::Port ports[2];
+	for (unsigned int i = 0; i < 2; i++) {
+		ports[i].link.reset(new Link_layer(interfaces[i],
+		 config.num_sequence_numbers,config.max_send_window_size,
+		 config.timeout,config.arq_mode));
+		ports[i].queue.reset(new Spsc_ring<Network_frame>(
+		 Network_node::QUEUE_LENGTH));
+		ports[i].neighbor = ends[1-i]->id;
+		ports[i].peer_port = ends[1-i]->ports.size();
+	}
+
+	// with room reserved, the moves below cannot throw
+	physical_layers.reserve(physical_layers.size()+1);
+	for (unsigned int i = 0; i < 2; i++) {
+		ends[i]->ports.reserve(ends[i]->ports.size()+1);
+	}
+	physical_layers.push_back(std::move(physical_layer));
+	for (unsigned int i = 0; i < 2; i++) {
+		ends[i]->ports.push_back(std::move(ports[i]));
+		ends[i]->ports.back().link->set_listener(
+		 &Network_node::wakeup,ends[i]);
+	}
+
+	return physical_layers.size()-1;
+}
+
+void Network::add_grid(unsigned int columns)
+{
+	if (columns == 0) {
+		throw Network_exception();
+	}
+	for (unsigned int i = 0; i < nodes.size(); i++) {
+		if ((i+1) % columns != 0 && i+1 < nodes.size()) {
+			add_link(i,i+1);
+		}
+		if (i+columns < nodes.size()) {
+			add_link(i,i+columns);
+		}
+	}
+}
+
+void Network::add_random_links(unsigned int num_links,unsigned int seed)
+{
+	if (nodes.size() < 2) {
+		throw Network_exception();
+	}
+	for (unsigned int i = 0; i < num_links; i++) {
+		unsigned int node0 = rand_r(&seed) % nodes.size();
+		unsigned int node1 = rand_r(&seed) % (nodes.size()-1);
+		if (node1 >= node0) {
+			node1++; // skip node0
+		}
+		add_link(node0,node1);
+	}
+}
+
+// one breadth-first search per destination: each node reached routes to
+// it through the port it was reached by, which gives every node a
+// shortest path in hops
+void Network::build_routes(void)
+{
+	unsigned int num_nodes = nodes.size();
+	vector<unsigned int> frontier(num_nodes);
+	vector<unsigned int> reached(num_nodes,0);
+
+	for (unsigned int i = 0; i < num_nodes; i++) {
+		nodes[i]->routes.assign(num_nodes,Network_node::NO_ROUTE);
+	}
+
+	for (unsigned int destination = 0; destination < num_nodes;
+	 destination++) {
+		// reached[n] == mark: n has a route to destination this pass
+		unsigned int mark = destination+1;
+		unsigned int head = 0,tail = 0;
+		frontier[tail++] = destination;
+		reached[destination] = mark;
+		while (head < tail) {
+			Network_node* node = nodes[frontier[head++]];
+			for (unsigned int i = 0; i < node->ports.size(); i++) {
+				const Network_node::Port& port = node->ports[i];
+				if (reached[port.neighbor] != mark) {
+					reached[port.neighbor] = mark;
+					nodes[port.neighbor]->routes[destination] =
+					 port.peer_port;
+					frontier[tail++] = port.neighbor;
+				}
+			}
+		}
+	}
+}
+
+Network_node* Network::get_node(unsigned int id)
+{
+	if (id >= nodes.size()) {
+		throw Network_exception();
+	}
+	return nodes[id];
+}
+
+unsigned int Network::get_num_nodes(void)
+{
+	return nodes.size();
+}
+
+unsigned int Network::get_num_links(void)
+{
+	return physical_layers.size();
+}
+
+Simulator* Network::get_simulator(void)
+{
+	return simulator;
+}
+
+void Network::poll(void)
+{
+	for (unsigned int i = 0; i < nodes.size(); i++) {
+		if (nodes[i]->pending.load(std::memory_order_acquire)) {
+			nodes[i]->process();
+		}
+	}
+}
+
+unsigned long Network::get_forwarded(void)
+{
+	unsigned long n = 0;
+	for (unsigned int i = 0; i < nodes.size(); i++) {
+		n += nodes[i]->forwarded;
+	}
+	return n;
+}
+
+unsigned long Network::get_delivered(void)
+{
+	unsigned long n = 0;
+	for (unsigned int i = 0; i < nodes.size(); i++) {
+		n += nodes[i]->delivered;
+	}
+	return n;
+}
+
+unsigned long Network::get_dropped(void)
+{
+	unsigned long n = 0;
+	for (unsigned int i = 0; i < nodes.size(); i++) {
+		n += nodes[i]->dropped;
+	}
+	return n;
+}
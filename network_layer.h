@@ -0,0 +1,172 @@
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include "link_layer.h"
+
+#ifndef NETWORK_LAYER_H
+#define NETWORK_LAYER_H
+
+using namespace std;
+
+class Network;
+
+// Network_exception ------------------------------------------------------
+
+class Network_exception: public exception {
+};
+
+// Network_header ---------------------------------------------------------
+
+// carried at the front of every Link_layer frame
+struct Network_header {
+	unsigned short source;
+	unsigned short destination;
+	unsigned short ttl; // hops left; the frame is dropped at 0
+};
+
+// a queued frame: Network_header and data, length bytes in all
+struct Network_frame {
+	unsigned int length;
+	unsigned char data[Link_layer::MAXIMUM_DATA_LENGTH];
+};
+
+// Link_config ------------------------------------------------------------
+
+// parameters of every point-to-point link a Network builds
+struct Link_config {
+	Impair impair;
+	unsigned int queue_depth;
+	unsigned int bandwidth;
+	unsigned int num_sequence_numbers;
+	unsigned int max_send_window_size;
+	unsigned int timeout;
+	Link_layer::Arq_mode arq_mode;
+
+	// unimpaired, one-frame channel; go-back-N with a window of 4
+	Link_config();
+};
+
+// Network_node -----------------------------------------------------------
+
+class Network_node {
+public:
+	enum {MAXIMUM_DATA_LENGTH =
+	 Link_layer::MAXIMUM_DATA_LENGTH-sizeof(Network_header)};
+	enum {DEFAULT_TTL = 255};
+	enum {NO_ROUTE = 255}; // routes entry for unreachable destinations
+	enum {MAXIMUM_PORTS = NO_ROUTE};
+
+	// queue length of every port and of the local receive queue
+	enum {QUEUE_LENGTH = 16};
+
+	unsigned int get_id(void);
+
+	// route length bytes from buffer to node destination; return 0 if
+	// the outgoing port's queue is full
+	unsigned int send(unsigned int destination,unsigned char buffer[],
+	 unsigned int length);
+
+	// copy the oldest frame addressed to this node to buffer, store its
+	// source, and return its length, or return 0 if there is none
+	unsigned int receive(unsigned char buffer[],unsigned int& source);
+
+	// listener is called whenever a frame is queued for receive; it must
+	// not block
+	void set_listener(void (*listener)(void*),void* listener_arg);
+
+	unsigned long get_forwarded(void);
+	unsigned long get_delivered(void);
+	unsigned long get_dropped(void);
+private:
+	friend class Network;
+
+	// one per link; the link's peer is node neighbor, where this link is
+	// port peer_port
+	struct Port {
+		unique_ptr<Link_layer> link;
+		unique_ptr<Spsc_ring<Network_frame> > queue; // waiting for link
+		unsigned int neighbor;
+		unsigned int peer_port;
+	};
+
+	Network_node(Network* network,unsigned int id);
+	~Network_node();
+
+	static void wakeup(void* node);
+	static void run_event(void* node);
+	void process(void);
+	void route(const unsigned char frame[],unsigned int length);
+	void flush(Port& port);
+
+	Network* network;
+	unsigned int id;
+	vector<Port> ports;
+
+	// next hop for each destination, as a port index, or NO_ROUTE: a
+	// byte per node in the network, on every node
+	vector<unsigned char> routes;
+
+	Spsc_ring<Network_frame> received;
+	void (*listener)(void*);
+	void* listener_arg;
+
+	// a link has delivered or freed send slots since the last process
+	std::atomic<bool> pending;
+	Simulator_timer event; // virtual-time mode: runs process
+
+	unsigned long forwarded,delivered,dropped;
+};
+
+// Network ----------------------------------------------------------------
+
+// nodes 0..num_nodes-1 wired by point-to-point Physical_layer links, with
+// shortest-path routing. With a simulator, nodes process their links as
+// simulator events; otherwise links run in real time and the application
+// calls poll()
+class Network {
+public:
+	// the routing tables take num_nodes*num_nodes bytes in all: 16 MiB
+	// at the maximum
+	enum {MAXIMUM_NODES = 4096};
+
+	Network(unsigned int num_nodes,const Link_config& config,
+	 Simulator* simulator = NULL);
+	~Network();
+
+	// connect two nodes; return the link's index
+	unsigned int add_link(unsigned int node0,unsigned int node1);
+
+	// connect the nodes as a grid, columns wide, row by row
+	void add_grid(unsigned int columns);
+
+	// add num_links links between distinct random nodes
+	void add_random_links(unsigned int num_links,unsigned int seed);
+
+	// compute every node's routes; call after the last add_*
+	void build_routes(void);
+
+	Network_node* get_node(unsigned int id);
+	unsigned int get_num_nodes(void);
+	unsigned int get_num_links(void);
+	Simulator* get_simulator(void);
+
+	// real-time mode: process every node whose links have work
+	void poll(void);
+
+	// totals over all nodes
+	unsigned long get_forwarded(void);
+	unsigned long get_delivered(void);
+	unsigned long get_dropped(void);
+private:
+	Network(const Network&);
+	Network& operator=(const Network&);
+
+	Link_config config;
+	Simulator* simulator;
+	vector<Network_node*> nodes;
+	vector<unique_ptr<Physical_layer> > physical_layers;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include "network_layer.h"
+
+using namespace std;
+
+// Network benchmark: builds a side x side grid of nodes, with extra random
+// links, on a Simulator, and routes packets between random pairs of nodes,
+// keeping a fixed number in flight. Reports the packets forwarded per
+// wall-clock second (one per hop), the cost of each hop, and the memory
+// per node. Every hop runs the full link layer on both ends.
+
+const unsigned int IN_FLIGHT_PER_NODE = 2;
+const unsigned int DELAY = 100; // microseconds each way
+
+vector<unsigned int> ready; // nodes with packets to receive
+
+void node_listener(void* node)
+{
+	ready.push_back(((Network_node*) node)->get_id());
+}
+
+double seconds(struct timeval t)
+{
+	return t.tv_sec+t.tv_usec/1000000.0;
+}
+
+int main(int argc,char* argv[])
+{
+	if (argc != 4) {
+		cout << "Syntax: " << argv[0] << " side packets seed" << endl;
+		exit(1);
+	}
+	unsigned int side = atoi(argv[1]);
+	unsigned long packets = atol(argv[2]);
+	unsigned int seed = atoi(argv[3]);
+	unsigned int num_nodes = side*side;
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF,&usage);
+	long rss_before = usage.ru_maxrss;
+
+	struct timeval build_start,build_stop;
+	gettimeofday(&build_start,NULL);
+	Simulator simulator;
+	Link_config config;
+	config.impair = Impair(NULL,0,NULL,0,DELAY);
+	config.queue_depth = 8;
+	config.num_sequence_numbers = 16;
+	config.max_send_window_size = 8;
+	config.timeout = 5000;
+	Network network(num_nodes,config,&simulator);
+	network.add_grid(side);
+	network.add_random_links(num_nodes/8,seed);
+	network.build_routes();
+	for (unsigned int i = 0; i < num_nodes; i++) {
+		network.get_node(i)->set_listener(&node_listener,
+		 network.get_node(i));
+	}
+	gettimeofday(&build_stop,NULL);
+
+	getrusage(RUSAGE_SELF,&usage);
+	long rss_after = usage.ru_maxrss;
+
+	unsigned char buffer[Network_node::MAXIMUM_DATA_LENGTH] = {0};
+	unsigned long injected = 0,received = 0,dropped = 0;
+	unsigned long in_flight = (unsigned long) IN_FLIGHT_PER_NODE*num_nodes;
+	unsigned long steps = 0;
+
+	struct timeval start,stop;
+	gettimeofday(&start,NULL);
+	while (received+dropped < packets) {
+		while (injected < packets && injected-received-dropped < in_flight) {
+			unsigned int source = rand_r(&seed) % num_nodes;
+			unsigned int destination = rand_r(&seed) % (num_nodes-1);
+			if (destination >= source) {
+				destination++;
+			}
+			if (network.get_node(source)->send(destination,buffer,
+			 Network_node::MAXIMUM_DATA_LENGTH) == 0) {
+				break;
+			}
+			injected++;
+		}
+		for (unsigned int i = 0; i < ready.size(); i++) {
+			unsigned int source;
+			while (network.get_node(ready[i])->receive(buffer,source) > 0) {
+				received++;
+			}
+		}
+		ready.clear();
+
+		// drops are rare; count them now and then, and when nothing moves
+		bool stalled = !simulator.step();
+		if (stalled || ++steps % 65536 == 0) {
+			dropped = network.get_dropped();
+		}
+		if (stalled && received+dropped < packets) {
+			cout << "network stalled" << endl;
+			exit(1);
+		}
+	}
+	gettimeofday(&stop,NULL);
+
+	double wall = seconds(stop-start);
+	unsigned long forwarded = network.get_forwarded();
+	cout << fixed << setprecision(2)
+	 << "nodes " << num_nodes << ", links " << network.get_num_links()
+	 << ", built in " << seconds(build_stop-build_start) << " s" << endl
+	 << "memory per node " << setprecision(1)
+	 << (rss_after-rss_before)*1024.0/num_nodes << " B" << endl
+	 << "packets " << received << " received, " << dropped << " dropped, "
+	 << setprecision(2) << (double) forwarded/received << " hops each"
+	 << endl
+	 << "forwarded " << forwarded << " in " << wall << " s wall, "
+	 << setprecision(3) << seconds(simulator.now()) << " s simulated"
+	 << endl
+	 << setprecision(0) << forwarded/wall << " forwarded packets/s, "
+	 << setprecision(0) << wall*1e9/forwarded << " ns per hop" << endl;
+
+	return 0;
+}
@@ -0,0 +1,90 @@
+#include <iostream>
+#include <stdlib.h>
+
+#include "network_layer.h"
+
+using namespace std;
+
+// Network test: a grid of ROWS x COLUMNS nodes on a Simulator. One packet
+// goes between every ordered pair of nodes, one at a time. Each must
+// reach its destination and no other node, with its source and data
+// intact, in as many hops as the Manhattan distance between the two, so
+// forwarded by one node fewer: the routes build_routes finds are
+// shortest paths.
+
+const unsigned int ROWS = 5;
+const unsigned int COLUMNS = 6;
+const unsigned int DELAY = 100; // microseconds each way
+
+int main(int argc,char* argv[])
+{
+	Simulator simulator;
+	Link_config config;
+	config.impair = Impair(NULL,0,NULL,0,DELAY);
+	Network network(ROWS*COLUMNS,config,&simulator);
+	network.add_grid(COLUMNS);
+	network.build_routes();
+	if (network.get_num_links() != ROWS*(COLUMNS-1)+(ROWS-1)*COLUMNS) {
+		cout << "FAIL: " << network.get_num_links() << " links" << endl;
+		return 1;
+	}
+
+	unsigned char buffer[Network_node::MAXIMUM_DATA_LENGTH];
+	for (unsigned int from = 0; from < ROWS*COLUMNS; from++) {
+		for (unsigned int to = 0; to < ROWS*COLUMNS; to++) {
+			if (to == from) {
+				continue;
+			}
+			unsigned long forwarded = network.get_forwarded();
+			buffer[0] = from;
+			buffer[1] = to;
+			if (network.get_node(from)->send(to,buffer,2) == 0) {
+				cout << "FAIL: " << from << " cannot send"
+				 << endl;
+				return 1;
+			}
+
+			// run until the path is quiet, then look everywhere
+			while (simulator.step()) {
+			}
+			unsigned int source = 0;
+			unsigned int length = 0;
+			for (unsigned int i = 0; i < ROWS*COLUMNS; i++) {
+				unsigned int n;
+				while ((n = network.get_node(i)->receive(buffer,
+				 source)) > 0) {
+					if (i != to || length != 0) {
+						cout << "FAIL: " << from
+						 << " -> " << to
+						 << " reached " << i << endl;
+						return 1;
+					}
+					length = n;
+				}
+			}
+			if (length != 2 || source != from || buffer[0] != from
+			 || buffer[1] != to) {
+				cout << "FAIL: " << from << " -> " << to
+				 << " was not delivered intact" << endl;
+				return 1;
+			}
+
+			unsigned int hops =
+			 abs((int) (from/COLUMNS)-(int) (to/COLUMNS))
+			 +abs((int) (from%COLUMNS)-(int) (to%COLUMNS));
+			forwarded = network.get_forwarded()-forwarded;
+			if (forwarded != hops-1) {
+				cout << "FAIL: " << from << " -> " << to
+				 << " was forwarded " << forwarded
+				 << " times on a path of " << hops << endl;
+				return 1;
+			}
+		}
+	}
+	if (network.get_dropped() != 0) {
+		cout << "FAIL: " << network.get_dropped() << " dropped" << endl;
+		return 1;
+	}
+	cout << "ok" << endl;
+	return 0;
+}
@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <math.h>
 #include <unistd.h>
+#include <string.h>
 #include "stdlib.h"
 
 #include "physical_layer.h"
@@ -9,12 +12,14 @@ using namespace std;
 // Impair --------------------------------------------------------
 Impair::Impair()
 {
+	*this = Impair(NULL,0,NULL,0,0);
 }
 
 Impair::Impair(
  double drop0[],unsigned int drop_length0,
  double corrupt0[],unsigned int corrupt_length0,
- unsigned int delay0)
+ unsigned int delay0,unsigned int seed)
+	: random(seed)
 {
 	// check for exceptions
 	if (drop_length0 > MAXIMUM_IMPAIR_LENGTH ||
@@ -32,69 +37,214 @@ Impair::Impair(
 		}
 	}
 
-	// copy drop parameters; initialize drop_index
+	// convert drop parameters to thresholds; initialize drop_index
 	drop_length = drop_length0;
-	if (drop_length > 0) {
-		for (unsigned int i = 0; i < drop_length; i++ ) {
-			drop[i]= drop0[i];
-		}
-		drop_index = 0;
+	for (unsigned int i = 0; i < drop_length; i++ ) {
+		drop[i] = Random::threshold(drop0[i]);
 	}
+	drop_index = 0;
 
-	// copy corrupt parameters; initialize corrupt_index
+	// convert corrupt parameters to thresholds; initialize corrupt_index
 	corrupt_length = corrupt_length0;
-	if (corrupt_length > 0) {
-		for (unsigned int i = 0; i < corrupt_length; i++ ) {
-			corrupt[i]= corrupt0[i];
+	for (unsigned int i = 0; i < corrupt_length; i++ ) {
+		corrupt[i] = Random::threshold(corrupt0[i]);
+	}
+	corrupt_index = 0;
+	corrupt_bits = 1;
+
+	burst = false;
+	burst_bad = false;
+	good_to_bad = bad_to_good = drop_good = drop_bad = 0;
+
+	delay = delay0;
+	jitter = JITTER_NONE;
+
+	reorder = 0;
+	duplicate = 0;
+
+	replay = NULL;
+	replay_index = 0;
+}
+
+static bool is_probability(double p)
+{
+	return 0.0 <= p && p <= 1.0;
+}
+
+void Impair::set_burst_loss(const Burst_loss& burst_loss)
+{
+	if (!is_probability(burst_loss.good_to_bad)
+	 || !is_probability(burst_loss.bad_to_good)
+	 || !is_probability(burst_loss.drop_good)
+	 || !is_probability(burst_loss.drop_bad)) {
+		throw Physical_layer_exception();
+	}
+	burst = true;
+	burst_bad = false;
+	good_to_bad = Random::threshold(burst_loss.good_to_bad);
+	bad_to_good = Random::threshold(burst_loss.bad_to_good);
+	drop_good = Random::threshold(burst_loss.drop_good);
+	drop_bad = Random::threshold(burst_loss.drop_bad);
+}
+
+// the table holds the distribution's quantiles at the middle of
+// JITTER_TABLE_LENGTH equal slices of probability, so a draw is an index
+void Impair::set_jitter(Jitter jitter0,unsigned int mean)
+{
+	if (jitter0 != JITTER_NONE && jitter0 != JITTER_UNIFORM
+	 && jitter0 != JITTER_EXPONENTIAL && jitter0 != JITTER_PARETO) {
+		throw Physical_layer_exception();
+	}
+	jitter = mean == 0 ? JITTER_NONE : jitter0;
+	for (unsigned int i = 0; i < JITTER_TABLE_LENGTH; i++) {
+		double u = (i+0.5)/JITTER_TABLE_LENGTH;
+		double x;
+		switch (jitter) {
+		case JITTER_UNIFORM:
+			x = 2*mean*u;
+			break;
+		case JITTER_EXPONENTIAL:
+			x = -(double) mean*log(1-u);
+			break;
+		case JITTER_PARETO:
+			// shifted to start at 0; shape 2 puts the mean at the scale
+			x = mean*(1/sqrt(1-u)-1);
+			break;
+		default:
+			x = 0;
 		}
-		corrupt_index = 0;
+		jitter_table[i] = (unsigned int) (x+0.5);
 	}
+}
 
-	// convert delay from microseconds to timeval
-	delay.tv_sec = delay0 / 1000000;
-	delay.tv_usec = delay0 % 1000000;
+void Impair::set_reorder(double probability)
+{
+	if (!is_probability(probability)) {
+		throw Physical_layer_exception();
+	}
+	reorder = Random::threshold(probability);
+}
 
-	rand_state = 1;
+void Impair::set_duplicate(double probability)
+{
+	if (!is_probability(probability)) {
+		throw Physical_layer_exception();
+	}
+	duplicate = Random::threshold(probability);
+}
+
+void Impair::set_corrupt_bits(unsigned int bits)
+{
+	if (bits == 0 || bits > MAXIMUM_CORRUPT_BITS) {
+		throw Physical_layer_exception();
+	}
+	corrupt_bits = bits;
+}
+
+void Impair::set_replay(const Replay* replay0,unsigned long long start)
+{
+	if (replay0 != NULL && start >= replay0->get_length()) {
+		throw Physical_layer_exception();
+	}
+	replay = replay0;
+	replay_index = start;
 }
 
 bool Impair::drop_packet(void)
 {
-	// no drop from empty drop array
-	if (drop_length == 0) {
-		return false;
+	if (replay != NULL) {
+		return (replay->get_event(replay_index) & REPLAY_DROPPED) != 0;
 	}
 
-	// get random int, scale to [0..1], compare to drop element
-	int r = rand_r(&rand_state);
-	return ((double)r / (double)RAND_MAX) < drop[drop_index];
+	bool dropped = false;
+	if (drop_length != 0) {
+		dropped = random.chance(drop[drop_index]);
+	}
+	if (burst) {
+		// step the chain, then draw in the state it is in
+		burst_bad = burst_bad ? !random.chance(bad_to_good)
+		 : random.chance(good_to_bad);
+		if (random.chance(burst_bad ? drop_bad : drop_good)) {
+			dropped = true;
+		}
+	}
+	return dropped;
 }
 
 bool Impair::corrupt_packet(unsigned char buffer[],unsigned int length)
 {
-	// no corruption from empty corrupt array
-	if (corrupt_length == 0) {
+	bool corrupted;
+	if (replay != NULL) {
+		corrupted =
+		 (replay->get_event(replay_index) & REPLAY_CORRUPTED) != 0;
+	} else {
+		// no corruption from empty corrupt array
+		corrupted = corrupt_length != 0
+		 && random.chance(corrupt[corrupt_index]);
+	}
+	if (!corrupted) {
 		return false;
 	}
 
-	// get random int, scale to [0..1], compare to corrupt element
-	int r = rand_r(&rand_state);
-	if (((double)r / (double)RAND_MAX) < corrupt[corrupt_index]) {
-		// get random int, scale i to [0..length-1], corrupt buffer[i]
-		int i = rand_r(&rand_state) % length;
-		buffer[i] ^= 0x01; // corrupt: invert low-order bit
-		return true;
+	// invert corrupt_bits distinct bits, or every bit of a short frame
+	unsigned int bits = 8*length;
+	unsigned int n = corrupt_bits < bits ? corrupt_bits : bits;
+	unsigned int flipped[MAXIMUM_CORRUPT_BITS];
+	for (unsigned int i = 0; i < n; i++) {
+		unsigned int bit;
+		bool repeat;
+		do {
+			bit = random.below(bits);
+			repeat = false;
+			for (unsigned int j = 0; j < i; j++) {
+				repeat = repeat || flipped[j] == bit;
+			}
+		} while (repeat);
+		flipped[i] = bit;
+		buffer[bit/8] ^= 1 << (bit%8);
 	}
-
-	return false;
+	return true;
 }
 
 struct timeval Impair::get_delay(void)
 {
-	return delay;
+	if (replay != NULL) {
+		return usec_to_timeval(replay->get_event(replay_index)
+		 & REPLAY_DELAY_MASK);
+	}
+
+	unsigned long usec = delay;
+	if (jitter != JITTER_NONE) {
+		usec += jitter_table[random.below(JITTER_TABLE_LENGTH)];
+	}
+	return usec_to_timeval(usec);
+}
+
+bool Impair::reorder_packet(void)
+{
+	return reorder != 0 && random.chance(reorder);
+}
+
+bool Impair::duplicate_packet(void)
+{
+	return duplicate != 0 && random.chance(duplicate);
 }
 
 void Impair::next(void)
 {
+	if (replay != NULL) {
+		// let go of the pages behind us as we stream through the file
+		replay_index++;
+		if (replay_index % Replay::RELEASE_EVENTS == 0) {
+			replay->release(replay_index-Replay::RELEASE_EVENTS,
+			 replay_index);
+		}
+		if (replay_index == replay->get_length()) {
+			replay->release(replay_index/Replay::RELEASE_EVENTS
+			 *Replay::RELEASE_EVENTS,replay_index);
+			replay_index = 0;
+		}
+	}
 	if (drop_length != 0) {
 		drop_index = (drop_index+1) % drop_length;
 	}
@@ -105,73 +255,234 @@ void Impair::next(void)
 
 // Physical_layer_interface  --------------------------------------------
 
-Physical_layer_interface::Physical_layer_interface(
- Physical_layer *physical_layer_p0,Impair &impair_p0,
+template <unsigned int MTU>
+Basic_physical_layer_interface<MTU>::Basic_physical_layer_interface(
+ Basic_physical_layer<MTU> *physical_layer_p0,Impair &impair_p0,
  void (*send_log0)(char,unsigned char[],unsigned int,bool,bool),
- void (*receive_log0)(char,unsigned char[],unsigned int))
+ void (*receive_log0)(char,unsigned char[],unsigned int),
+ unsigned int queue_depth,unsigned int bandwidth0)
+	: frames(queue_depth)
 {
+	if (queue_depth == 0) {
+		throw Physical_layer_exception();
+	}
+
 	impair = Impair(impair_p0);
 	physical_layer_p = physical_layer_p0;
 
 	send_log = send_log0;
 	receive_log = receive_log0;
 
-	buffer_length = 0;
+	frame_head = 0;
+	frame_count = 0;
+
+	bandwidth = bandwidth0;
+	wire_free_time.tv_sec = 0;
+	wire_free_time.tv_usec = 0;
+	wire_free_remainder = 0;
+
+	listener = NULL;
+	listener_arg = NULL;
+	trace = NULL;
+	loaned = false;
 }
 
-int Physical_layer_interface::send(unsigned char buffer[],unsigned int length)
+template <unsigned int MTU>
+void Basic_physical_layer_interface<MTU>::set_listener(
+ void (*listener0)(void*),void* listener_arg0)
 {
-	// ensure length is safe to use
-	if (length == 0 || length > MAXIMUM_BUFFER_LENGTH) {
-		throw Physical_layer_exception();
+	physical_layer_p->lock_buffers(); // ***** LOCK
+	listener = listener0;
+	listener_arg = listener_arg0;
+	physical_layer_p->unlock_buffers(); // ***** UNLOCK
+}
+
+template <unsigned int MTU>
+void Basic_physical_layer_interface<MTU>::set_trace(Trace_ring* trace0)
+{
+	physical_layer_p->lock_buffers(); // ***** LOCK
+	trace = trace0;
+	physical_layer_p->unlock_buffers(); // ***** UNLOCK
+}
+
+template <unsigned int MTU>
+char Basic_physical_layer_interface<MTU>::get_side(void)
+{
+	return this == physical_layer_p->get_a_interface() ? 'a' : 'b';
+}
+
+template <unsigned int MTU>
+bool Basic_physical_layer_interface<MTU>::get_release_time(
+ struct timeval& release_time)
+{
+	bool pending;
+
+	physical_layer_p->lock_buffers(); // ***** LOCK
+	pending = frame_count > 0;
+	if (pending) {
+		release_time = frames[frame_head].release_time;
+	}
+	physical_layer_p->unlock_buffers(); // ***** UNLOCK
+
+	return pending;
+}
+
+template <unsigned int MTU>
+Clock* Basic_physical_layer_interface<MTU>::get_clock(void)
+{
+	return physical_layer_p->get_clock();
+}
+
+template <unsigned int MTU>
+Simulator* Basic_physical_layer_interface<MTU>::get_simulator(void)
+{
+	return physical_layer_p->get_simulator();
+}
+
+template <unsigned int MTU>
+Physical_layer_metrics Basic_physical_layer_interface<MTU>::get_metrics(void)
+{
+	Physical_layer_metrics m;
+	m.frames_sent = metrics.frames_sent.get();
+	m.bytes_sent = metrics.bytes_sent.get();
+	m.busy = metrics.busy.get();
+	m.dropped = metrics.dropped.get();
+	m.corrupted = metrics.corrupted.get();
+	m.reordered = metrics.reordered.get();
+	m.duplicated = metrics.duplicated.get();
+	m.frames_received = metrics.frames_received.get();
+	m.queue_occupancy = metrics.queue_occupancy.get();
+	return m;
+}
+
+// caller holds the buffer lock
+template <unsigned int MTU>
+void Basic_physical_layer_interface<MTU>::notify(void)
+{
+	if (listener != NULL) {
+		listener(listener_arg);
+	}
+}
+
+template <unsigned int MTU>
+int Basic_physical_layer_interface<MTU>::send(unsigned char buffer[],
+ unsigned int length)
+{
+	unsigned char* buffers[1] = {buffer};
+	return send_many(buffers,&length,1);
+}
+
+template <unsigned int MTU>
+unsigned int Basic_physical_layer_interface<MTU>::send_many(
+ unsigned char* buffer[],unsigned int length[],unsigned int num_frames)
+{
+	// ensure every length is safe to use before sending any
+	for (unsigned int i = 0; i < num_frames; i++) {
+		if (length[i] == 0 || length[i] > MAXIMUM_BUFFER_LENGTH) {
+			throw Physical_layer_exception();
+		}
 	}
 
 	// delegate to the appropriate interface
-	int n;
+	Basic_physical_layer_interface *send_interface,*receive_interface;
 	if (this == physical_layer_p->get_a_interface()) {
-		n = send(buffer,length,
-		 physical_layer_p->get_a_interface(),
-		 physical_layer_p->get_b_interface());
+		send_interface = physical_layer_p->get_a_interface();
+		receive_interface = physical_layer_p->get_b_interface();
 	} else {
-		n = send(buffer,length,
-		 physical_layer_p->get_b_interface(),
-		 physical_layer_p->get_a_interface());
+		send_interface = physical_layer_p->get_b_interface();
+		receive_interface = physical_layer_p->get_a_interface();
+	}
+
+	struct timeval now = physical_layer_p->get_clock()->now();
+
+	unsigned int n = 0;
+	bool delivered = false;
+	physical_layer_p->lock_buffers(); // ***** LOCK
+	while (n < num_frames && send(buffer[n],length[n],
+	 send_interface,receive_interface,now,delivered) > 0) {
+		n++;
+	}
+	if (n < num_frames) {
+		send_interface->metrics.busy.add();
 	}
+	// wake the receiving side once per batch
+	if (delivered) {
+		receive_interface->notify();
+	}
+	physical_layer_p->unlock_buffers(); // ***** UNLOCK
 
 	return n;
 }
 
-int Physical_layer_interface::send
+// caller holds the buffer lock; sets delivered if the frame was not dropped
+template <unsigned int MTU>
+int Basic_physical_layer_interface<MTU>::send
  (unsigned char send_buffer[],unsigned int send_buffer_length,
- Physical_layer_interface *send_interface,
- Physical_layer_interface *receive_interface)
+ Basic_physical_layer_interface *send_interface,
+ Basic_physical_layer_interface *receive_interface,
+ const struct timeval& now,bool& delivered)
 {
-	physical_layer_p->lock_buffers(); // ***** LOCK
 	// return if device busy
-	if (receive_interface->buffer_length > 0) {
-		physical_layer_p->unlock_buffers(); // ***** UNLOCK
+	vector<Frame>& frames = receive_interface->frames;
+	if (receive_interface->frame_count == frames.size()) {
 		return 0;
 	}
 
-	// copy send_buffer
-	for (unsigned int i = 0; i < send_buffer_length; i++) {
-		receive_interface->buffer[i] = send_buffer[i];
+	receive_interface->metrics.queue_occupancy.record(
+	 receive_interface->frame_count);
+
+	// copy send_buffer into the slot after the newest frame
+	unsigned int slot = (receive_interface->frame_head
+	 +receive_interface->frame_count) % frames.size();
+	Frame& frame = frames[slot];
+	memcpy(frame.buffer,send_buffer,send_buffer_length);
+	frame.length = send_buffer_length;
+
+	// apply impairment; every decision is drawn for every frame, so the
+	// sequence of draws depends only on the number of frames sent
+	Impair& impair = send_interface->impair;
+	bool is_corrupted = impair.corrupt_packet(frame.buffer,send_buffer_length);
+	bool will_be_dropped = impair.drop_packet();
+
+	// compute release time: the frame finishes serializing after any
+	// frame still on the wire ahead of it, then propagates
+	frame.release_time = receive_interface->serialize(send_buffer_length,now)
+	 +impair.get_delay();
+
+	// a reordered frame overtakes the frame in flight ahead of it, unless
+	// that one is out on loan; a duplicate needs a slot of its own
+	bool is_reordered = impair.reorder_packet() && !will_be_dropped
+	 && receive_interface->frame_count > 0
+	 && !(receive_interface->frame_count == 1 && receive_interface->loaned);
+	bool is_duplicated = impair.duplicate_packet() && !will_be_dropped
+	 && receive_interface->frame_count+1 < frames.size();
+
+	impair.next(); // for next send
+
+	if (send_interface->trace != NULL) {
+		send_interface->trace->record(timeval_to_usec(now),
+		 send_interface->get_side(),TRACE_SEND,
+		 (will_be_dropped ? TRACE_DROPPED : 0)
+		 | (is_corrupted ? TRACE_CORRUPTED : 0)
+		 | (is_reordered ? TRACE_REORDERED : 0)
+		 | (is_duplicated ? TRACE_DUPLICATED : 0),
+		 frame.buffer,frame.length);
 	}
-	receive_interface->buffer_length = send_buffer_length;
 
-	// apply impairment
-	receive_interface->buffer_is_corrupted =
-	 send_interface->impair.corrupt_packet
-	 (receive_interface->buffer,send_buffer_length);
-	receive_interface->buffer_will_be_dropped =
-	 send_interface->impair.drop_packet();
-
-	// compute release time
-	gettimeofday(&receive_interface->buffer_release_time,NULL);
-	receive_interface->buffer_release_time +=
-	 send_interface->impair.get_delay();
-
-	send_interface->impair.next(); // for next send
+	send_interface->metrics.frames_sent.add();
+	send_interface->metrics.bytes_sent.add(send_buffer_length);
+	if (is_corrupted) {
+		send_interface->metrics.corrupted.add();
+	}
+	if (will_be_dropped) {
+		send_interface->metrics.dropped.add();
+	}
+	if (is_reordered) {
+		send_interface->metrics.reordered.add();
+	}
+	if (is_duplicated) {
+		send_interface->metrics.duplicated.add();
+	}
 
 	// handle send logging
 	if (send_log != NULL) {
@@ -181,99 +492,282 @@ int Physical_layer_interface::send
 		} else {
 			side = 'b';
 		}
-		send_log(side,
-		 receive_interface->buffer,receive_interface->buffer_length,
-		 receive_interface->buffer_will_be_dropped,
-		 receive_interface->buffer_is_corrupted);
+		send_log(side,frame.buffer,frame.length,
+		 will_be_dropped,is_corrupted);
 	}
 
-	// set length to force drop
-	if (receive_interface->buffer_will_be_dropped) {
-		receive_interface->buffer_length = 0;
+	// leave the slot free to force drop
+	if (!will_be_dropped) {
+		receive_interface->frame_count++;
+		delivered = true;
+	}
+
+	// swap contents with the frame ahead, keeping the release times in
+	// place: the new frame arrives first
+	if (is_reordered) {
+		unsigned int ahead = (slot+frames.size()-1) % frames.size();
+		Frame& previous = frames[ahead];
+		unsigned int longer = previous.length > frame.length
+		 ? previous.length : frame.length;
+		swap_ranges(frame.buffer,frame.buffer+longer,previous.buffer);
+		swap(frame.length,previous.length);
+		slot = ahead;
+	}
+
+	// the copy arrives just behind the newest frame
+	if (is_duplicated) {
+		unsigned int end = receive_interface->frame_head
+		 +receive_interface->frame_count;
+		Frame& newest = frames[(end-1) % frames.size()];
+		Frame& copy = frames[end % frames.size()];
+		memcpy(copy.buffer,frames[slot].buffer,frames[slot].length);
+		copy.length = frames[slot].length;
+		copy.release_time = newest.release_time;
+		receive_interface->frame_count++;
 	}
-	physical_layer_p->unlock_buffers(); // ***** UNLOCK
 
 	return send_buffer_length;
 }
 
-unsigned int Physical_layer_interface::receive(unsigned char buffer[])
+// caller holds the buffer lock; return when a frame of length bytes sent
+// into this interface at now has been clocked onto the wire
+template <unsigned int MTU>
+struct timeval Basic_physical_layer_interface<MTU>::serialize(
+ unsigned int length,const struct timeval& now)
 {
-	int n;
+	if (bandwidth == 0) {
+		return now;
+	}
 
-	if (this == physical_layer_p->get_a_interface()) {
-		n = receive(buffer,physical_layer_p->get_a_interface());
-	} else {
-		n = receive(buffer,physical_layer_p->get_b_interface());
+	// an idle wire starts at now; a busy one after the frame ahead
+	if (wire_free_time < now) {
+		wire_free_time = now;
+		wire_free_remainder = 0;
 	}
-	return n;
+
+	// carry the fraction of a microsecond to the next frame so
+	// back-to-back frames serialize at exactly bandwidth
+	unsigned long long bit_usec =
+	 (unsigned long long) length*8*1000000+wire_free_remainder;
+	unsigned long long usec = bit_usec/bandwidth;
+	wire_free_remainder = bit_usec % bandwidth;
+
+	struct timeval delay;
+	delay.tv_sec = usec / 1000000;
+	delay.tv_usec = usec % 1000000;
+	wire_free_time += delay;
+
+	return wire_free_time;
 }
 
-int Physical_layer_interface::receive(unsigned char receive_buffer[],
- Physical_layer_interface *interface)
+template <unsigned int MTU>
+unsigned int Basic_physical_layer_interface<MTU>::receive(
+ unsigned char buffer[])
 {
-	struct timeval now;
-	int length;
+	unsigned int length;
+	unsigned char* buffers[1] = {buffer};
 
-	gettimeofday(&now,NULL);
+	if (receive_many(buffers,&length,1) == 0) {
+		return 0;
+	}
+	return length;
+}
+
+template <unsigned int MTU>
+unsigned int Basic_physical_layer_interface<MTU>::receive_many(
+ unsigned char* buffer[],unsigned int length[],unsigned int max_frames)
+{
+	struct timeval now = physical_layer_p->get_clock()->now();
 
+	unsigned int n = 0;
 	physical_layer_p->lock_buffers(); // ***** LOCK
-	if (interface->buffer_length > 0 &&
-	 interface->buffer_release_time < now) {
-		if (interface->buffer_will_be_dropped) {
-			length = 0; // no data to return
+	while (n < max_frames && (length[n] = receive(buffer[n],now)) > 0) {
+		n++;
+	}
+	// the channel into this interface is free again
+	if (n > 0) {
+		if (this == physical_layer_p->get_a_interface()) {
+			physical_layer_p->get_b_interface()->notify();
 		} else {
-			// copy buffer
-			for (unsigned int i = 0;
-			 i < interface->buffer_length; i++) {
-				receive_buffer[i] = interface->buffer[i];
-			}
-			length = interface->buffer_length;
+			physical_layer_p->get_a_interface()->notify();
 		}
-		interface->buffer_length = 0; // release buffer
+	}
+	physical_layer_p->unlock_buffers(); // ***** UNLOCK
+
+	return n;
+}
+
+// caller holds the buffer lock
+template <unsigned int MTU>
+unsigned int Basic_physical_layer_interface<MTU>::receive(
+ unsigned char receive_buffer[],const struct timeval& now)
+{
+	unsigned int length;
+
+	// dropped frames never occupy a slot, see send
+	Frame& frame = frames[frame_head];
+	if (frame_count > 0 && frame.release_time <= now) {
+		// copy buffer
+		memcpy(receive_buffer,frame.buffer,frame.length);
+		length = frame.length;
+		if (trace != NULL) {
+			trace->record(timeval_to_usec(now),get_side(),TRACE_RECEIVE,0,
+			 frame.buffer,frame.length);
+		}
+		release_frame();
 	} else {
 		length = 0; // no data to return
 	}
-	if (interface->receive_log != NULL && length > 0) {
+	if (receive_log != NULL && length > 0) {
 		char side;
 		if (this == physical_layer_p->get_a_interface()) {
 			side = 'a';
 		} else {
 			side = 'b';
 		}
-		interface->receive_log(side,receive_buffer,length);
+		receive_log(side,receive_buffer,length);
 	}
-	physical_layer_p->unlock_buffers(); // ***** UNLOCK
 
 	return length;
 }
 
+template <unsigned int MTU>
+const unsigned char* Basic_physical_layer_interface<MTU>::receive_loan(
+ unsigned int& length)
+{
+	struct timeval now = physical_layer_p->get_clock()->now();
+	const unsigned char* frame = NULL;
+
+	physical_layer_p->lock_buffers(); // ***** LOCK
+	// dropped frames never occupy a slot, see send
+	if (frame_count > 0 && frames[frame_head].release_time <= now) {
+		frame = frames[frame_head].buffer;
+		length = frames[frame_head].length;
+		loaned = true;
+		if (trace != NULL) {
+			trace->record(timeval_to_usec(now),get_side(),TRACE_RECEIVE,0,
+			 frame,length);
+		}
+		if (receive_log != NULL) {
+			char side;
+			if (this == physical_layer_p->get_a_interface()) {
+				side = 'a';
+			} else {
+				side = 'b';
+			}
+			receive_log(side,frames[frame_head].buffer,length);
+		}
+	}
+	physical_layer_p->unlock_buffers(); // ***** UNLOCK
+
+	// send only writes free slots, and never moves a frame on loan, so
+	// the frame is ours until receive_release
+	return frame;
+}
+
+// caller holds the buffer lock
+template <unsigned int MTU>
+void Basic_physical_layer_interface<MTU>::release_frame(void)
+{
+	frame_head = (frame_head+1) % frames.size();
+	frame_count--;
+	loaned = false;
+	metrics.frames_received.add();
+}
+
+template <unsigned int MTU>
+void Basic_physical_layer_interface<MTU>::receive_release(void)
+{
+	physical_layer_p->lock_buffers(); // ***** LOCK
+	if (frame_count > 0) {
+		release_frame();
+	}
+
+	// the channel into this interface is free again
+	if (this == physical_layer_p->get_a_interface()) {
+		physical_layer_p->get_b_interface()->notify();
+	} else {
+		physical_layer_p->get_a_interface()->notify();
+	}
+	physical_layer_p->unlock_buffers(); // ***** UNLOCK
+}
+
 // Physical_layer --------------------------------------------------------
 
-Physical_layer::Physical_layer(Impair &a_impair,Impair &b_impair,
+template <unsigned int MTU>
+Basic_physical_layer<MTU>::Basic_physical_layer(
+ Impair &a_impair,Impair &b_impair,
  void (*send_log)(char,unsigned char[],unsigned int,bool,bool),
- void (*receive_log)(char,unsigned char[],unsigned int))
+ void (*receive_log)(char,unsigned char[],unsigned int),
+ unsigned int queue_depth,unsigned int bandwidth,Simulator* simulator0)
 {
-	a_interface = new Physical_layer_interface(this,a_impair,
-	 send_log,receive_log);
-	b_interface = new Physical_layer_interface(this,b_impair,
-	 send_log,receive_log);
+	if (queue_depth == 0) {
+		throw Physical_layer_exception();
+	}
+
+	simulator = simulator0;
+	if (simulator != NULL) {
+		clock = simulator;
+	} else {
+		clock = &real_clock;
+	}
+
+	a_interface = new Basic_physical_layer_interface<MTU>(this,a_impair,
+	 send_log,receive_log,queue_depth,bandwidth);
+	b_interface = new Basic_physical_layer_interface<MTU>(this,b_impair,
+	 send_log,receive_log,queue_depth,bandwidth);
 
 	pthread_mutex_init(&buffer_mutex,NULL);
 }
 
-Physical_layer_interface* Physical_layer::get_a_interface()
+template <unsigned int MTU>
+Basic_physical_layer<MTU>::~Basic_physical_layer()
+{
+	delete a_interface;
+	delete b_interface;
+
+	pthread_mutex_destroy(&buffer_mutex);
+}
+
+template <unsigned int MTU>
+Basic_physical_layer_interface<MTU>*
+Basic_physical_layer<MTU>::get_a_interface()
 {
 	return a_interface;
 }
-Physical_layer_interface* Physical_layer::get_b_interface()
+template <unsigned int MTU>
+Basic_physical_layer_interface<MTU>*
+Basic_physical_layer<MTU>::get_b_interface()
 {
 	return b_interface;
 }
-void Physical_layer::lock_buffers(void)
+template <unsigned int MTU>
+Clock* Basic_physical_layer<MTU>::get_clock(void)
+{
+	return clock;
+}
+template <unsigned int MTU>
+Simulator* Basic_physical_layer<MTU>::get_simulator(void)
+{
+	return simulator;
+}
+template <unsigned int MTU>
+void Basic_physical_layer<MTU>::lock_buffers(void)
 {
 	pthread_mutex_lock(&buffer_mutex);
 }
-void Physical_layer::unlock_buffers(void)
+template <unsigned int MTU>
+void Basic_physical_layer<MTU>::unlock_buffers(void)
 {
 	pthread_mutex_unlock(&buffer_mutex);
 }
+
+// the MTUs built into this library; another needs a line of its own
+template class Basic_physical_layer_interface<32>;
+template class Basic_physical_layer<32>;
+template class Basic_physical_layer_interface<100>;
+template class Basic_physical_layer<100>;
+template class Basic_physical_layer_interface<1500>;
+template class Basic_physical_layer<1500>;
+template class Basic_physical_layer_interface<9000>;
+template class Basic_physical_layer<9000>;
@@ -1,10 +1,17 @@
 #include <iostream>
+#include <vector>
 #include <pthread.h>
 #include "sys/time.h"
 
+#include "metrics.h"
+#include "random.h"
+#include "replay.h"
+#include "simulator.h"
+#include "trace.h"
+
 using namespace std;
 
-class Physical_layer;
+template <unsigned int MTU> class Basic_physical_layer;
 
 // Physical_layer_exception ---------------------------------------------
 
@@ -13,76 +20,255 @@ class Physical_layer_exception: public exception {
 
 // Impair ---------------------------------------------------------------
 
+// Gilbert-Elliott burst loss: a two-state Markov chain stepped once per
+// frame sent, dropping frames with probability drop_good in the good
+// state and drop_bad in the bad one
+struct Burst_loss {
+	double good_to_bad; // per frame
+	double bad_to_good; // per frame: bursts last 1/bad_to_good frames
+	double drop_good;
+	double drop_bad;
+};
+
+// What the channel does to each frame sent into it: a frame accepted by
+// send may be corrupted, dropped, delayed, reordered and duplicated.
+// Every decision is a draw from a seeded xoshiro256** compared with an
+// integer threshold, a few nanoseconds each. A Physical_layer copies its
+// Impairs, so set them up before constructing it
 class Impair {
 public:
 	enum {MAXIMUM_IMPAIR_LENGTH = 50};
+	enum {MAXIMUM_CORRUPT_BITS = 64};
+	enum {JITTER_TABLE_LENGTH = 1024};
+	// distribution of the jitter added to the fixed delay
+	enum Jitter {JITTER_NONE, JITTER_UNIFORM, JITTER_EXPONENTIAL,
+	 JITTER_PARETO};
 
+	// no impairment
 	Impair();
-	Impair(double*,unsigned int,double*,unsigned int,unsigned int);
+	// frame i is dropped with probability drop[i%drop_length] and
+	// corrupted with probability corrupt[i%corrupt_length], and every
+	// frame is delayed by delay microseconds
+	Impair(double* drop,unsigned int drop_length,double* corrupt,
+	 unsigned int corrupt_length,unsigned int delay,unsigned int seed = 1);
+
+	// burst loss on top of the drop array: a frame either one drops is
+	// lost
+	void set_burst_loss(const Burst_loss& burst_loss);
+	// add a delay of mean microseconds on average, drawn from jitter: up
+	// to 2*mean uniformly, exponential, or Pareto (shape 2, heavy tailed)
+	void set_jitter(Jitter jitter,unsigned int mean);
+	// the probability that a frame overtakes the one ahead of it
+	void set_reorder(double probability);
+	// the probability that a frame arrives twice
+	void set_duplicate(double probability);
+	// bits flipped in a corrupted frame, at distinct random positions
+	void set_corrupt_bits(unsigned int bits);
+	// take each frame's drop, corruption and delay from the next event of
+	// replay, starting at event start and going round again at the end,
+	// instead of from the arrays, burst loss, delay and jitter. replay
+	// must outlive the Physical_layer; NULL stops replaying
+	void set_replay(const Replay* replay,unsigned long long start = 0);
 
 	bool drop_packet(void);
 	bool corrupt_packet(unsigned char buffer[],unsigned int length);
 	struct timeval get_delay(void);
+	bool reorder_packet(void);
+	bool duplicate_packet(void);
 	void next(void);
 private:
-	double drop[MAXIMUM_IMPAIR_LENGTH];
+	// probabilities as Random::threshold()s
+	unsigned long long drop[MAXIMUM_IMPAIR_LENGTH];
 	unsigned int drop_length,drop_index;
 
-	double corrupt[MAXIMUM_IMPAIR_LENGTH];
+	unsigned long long corrupt[MAXIMUM_IMPAIR_LENGTH];
 	unsigned int corrupt_length,corrupt_index;
+	unsigned int corrupt_bits;
+
+	bool burst; // burst loss is on
+	bool burst_bad; // the chain is in the bad state
+	unsigned long long good_to_bad,bad_to_good,drop_good,drop_bad;
+
+	unsigned int delay; // microseconds
+	Jitter jitter;
+	// quantiles of the jitter distribution at evenly spaced
+	// probabilities; a draw picks one
+	unsigned int jitter_table[JITTER_TABLE_LENGTH];
+
+	unsigned long long reorder,duplicate;
 
-	struct timeval delay;
-	unsigned int rand_state;
+	const Replay* replay;
+	unsigned long long replay_index;
+
+	Random random;
+};
+
+// Physical_layer_metrics ------------------------------------------------
+
+// counts of one interface since it was created: the frames it sent into
+// its channel and what became of them, and the frames it received
+struct Physical_layer_metrics {
+	unsigned long frames_sent; // dropped ones included
+	unsigned long bytes_sent;
+	unsigned long busy; // send calls that found the channel full
+	unsigned long dropped; // by Impair
+	unsigned long corrupted; // by Impair
+	unsigned long reordered; // by Impair
+	unsigned long duplicated; // by Impair
+	unsigned long frames_received;
+	// frames in flight into this interface as each frame was sent to it
+	Histogram_snapshot queue_occupancy;
 };
 
 // Physical_layer_interface ----------------------------------------------
 
-class Physical_layer_interface {
+// one end of a Basic_physical_layer carrying frames of up to MTU bytes.
+// Each MTU is a class of its own, with its frame slots sized at compile
+// time; physical_layer.cpp instantiates the MTUs there is a use for
+template <unsigned int MTU>
+class Basic_physical_layer_interface {
 public:
-	enum {MAXIMUM_BUFFER_LENGTH = 100};
+	enum {MAXIMUM_BUFFER_LENGTH = MTU};
 
-	Physical_layer_interface(Physical_layer*,Impair&,
+	Basic_physical_layer_interface(Basic_physical_layer<MTU>*,Impair&,
 	 void (*send_log)(char,unsigned char[],unsigned int,bool,bool),
-	 void (*receive_log)(char,unsigned char[],unsigned int));
+	 void (*receive_log)(char,unsigned char[],unsigned int),
+	 unsigned int queue_depth = 1,unsigned int bandwidth = 0);
 
 	unsigned int receive(unsigned char buffer[]);
 
+	// like receive, but return the frame in place instead of copying it;
+	// its queue slot stays taken until receive_release
+	const unsigned char* receive_loan(unsigned int& length);
+	void receive_release(void);
+
 	int send(unsigned char buffer[],unsigned int length);
+
+	// send frame i from buffer[i][0..length[i]-1], in order, until the
+	// channel is busy; take the lock and read the clock once for the batch
+	// and return the number of frames sent
+	unsigned int send_many(unsigned char* buffer[],unsigned int length[],
+	 unsigned int num_frames);
+
+	// receive up to max_frames ready frames into buffer[i], storing their
+	// lengths in length[i]; return the number of frames received
+	unsigned int receive_many(unsigned char* buffer[],unsigned int length[],
+	 unsigned int max_frames);
+
+	// listener is called, with the buffer lock held, whenever a frame is
+	// delivered to this interface or its outbound channel becomes free.
+	// It must not block, and may take no lock but one that comes after
+	// the buffer lock in the order link mutex, buffer lock, Reactor shard
+	// lock. A link on a Reactor takes its shard's lock here to schedule
+	// its loop
+	void set_listener(void (*listener)(void*),void* listener_arg);
+
+	// if a frame is in flight to this interface, store the time at which
+	// receive can return the oldest one and return true
+	bool get_release_time(struct timeval& release_time);
+
+	// the physical layer's time source, and its Simulator, or NULL if it
+	// runs in real time
+	Clock* get_clock(void);
+	Simulator* get_simulator(void);
+
+	// lock-free; any thread may poll it while the layer runs
+	Physical_layer_metrics get_metrics(void);
+
+	// record every frame this interface sends or receives in trace, or
+	// stop if it is NULL. Recording takes a copy into the ring, with
+	// the buffer lock held; a Trace_writer writes the ring out
+	void set_trace(Trace_ring* trace);
 private:
 	int send(unsigned char[],unsigned int,
-	 Physical_layer_interface*,Physical_layer_interface*);
+	 Basic_physical_layer_interface*,Basic_physical_layer_interface*,
+	 const struct timeval&,bool&);
 
 	void (*send_log)(char,unsigned char[],unsigned int,bool,bool);
 	void (*receive_log)(char,unsigned char[],unsigned int);
 
-	int receive(unsigned char[],Physical_layer_interface*);
+	unsigned int receive(unsigned char[],const struct timeval&);
+	void release_frame(void);
+	struct timeval serialize(unsigned int,const struct timeval&);
+
+	void notify(void);
+	void (*listener)(void*);
+	void* listener_arg;
+
+	char get_side(void);
+	Trace_ring* trace;
 
-	Physical_layer *physical_layer_p;
+	// the oldest frame is out on loan: send must leave its slot alone
+	bool loaned;
+
+	Basic_physical_layer<MTU> *physical_layer_p;
 	Impair impair;
 
-	// buffer state
-	unsigned int buffer_length; // ignore other fields if buffer_length is 0
-	unsigned char buffer[MAXIMUM_BUFFER_LENGTH];
-	struct timeval buffer_release_time;
-	bool buffer_is_corrupted,buffer_will_be_dropped;
+	// a frame in flight to this interface
+	struct Frame {
+		alignas(8) unsigned char buffer[MAXIMUM_BUFFER_LENGTH];
+		unsigned int length;
+		struct timeval release_time;
+	};
+
+	// FIFO of frames in flight to this interface, oldest at frame_head;
+	// send returns 0 while all queue_depth slots are taken. Dropped frames
+	// never take a slot
+	vector<Frame> frames;
+	unsigned int frame_head,frame_count;
+
+	// bits per second into this interface, or 0 for no serialization
+	// delay; wire_free_time is when the last frame sent finishes
+	// serializing, less wire_free_remainder/bandwidth microseconds
+	unsigned int bandwidth;
+	struct timeval wire_free_time;
+	unsigned long long wire_free_remainder;
+
+	// written with the buffer lock held, read by get_metrics without it
+	struct {
+		Counter frames_sent,bytes_sent,busy,dropped,corrupted;
+		Counter reordered,duplicated;
+		Counter frames_received;
+		Histogram queue_occupancy;
+	} metrics;
 };
 
 // Physical_layer --------------------------------------------------------
 
-class Physical_layer {
+template <unsigned int MTU>
+class Basic_physical_layer {
 public:
-	Physical_layer(Impair&,Impair&,
+	// each direction holds up to queue_depth frames in flight and, if
+	// bandwidth (bits per second) is not 0, serializes them one at a time.
+	// With a simulator all times are the simulator's virtual time
+	Basic_physical_layer(Impair&,Impair&,
 	 void (*send_log)(char,unsigned char[],unsigned int,bool,bool),
-	 void (*receive_log)(char,unsigned char[],unsigned int));
+	 void (*receive_log)(char,unsigned char[],unsigned int),
+	 unsigned int queue_depth = 1,unsigned int bandwidth = 0,
+	 Simulator* simulator = NULL);
+	// frees both interfaces: destroy every Link_layer attached to them
+	// first, or its protocol loop may still be using one
+	~Basic_physical_layer();
 
-	Physical_layer_interface *get_a_interface(void);
+	Basic_physical_layer_interface<MTU> *get_a_interface(void);
 
-	Physical_layer_interface *get_b_interface(void);
+	Basic_physical_layer_interface<MTU> *get_b_interface(void);
+
+	Clock* get_clock(void);
+	Simulator* get_simulator(void);
 
 	void lock_buffers();
 	void unlock_buffers();
 private:
 	pthread_mutex_t buffer_mutex;
 
-	Physical_layer_interface *a_interface,*b_interface;
+	Basic_physical_layer_interface<MTU> *a_interface,*b_interface;
+
+	Real_clock real_clock;
+	Clock* clock; // simulator or &real_clock
+	Simulator* simulator;
 };
+
+// the classic 100-byte frame
+typedef Basic_physical_layer_interface<100> Physical_layer_interface;
+typedef Basic_physical_layer<100> Physical_layer;
@@ -0,0 +1,70 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+// Random -----------------------------------------------------------------
+
+// xoshiro256** (Blackman and Vigna), seeded through splitmix64: a few
+// nanoseconds a number, and the same sequence for the same seed on every
+// platform. Probabilities are compared as 64-bit integer thresholds, so
+// a decision is a draw and a compare, with no floating point
+class Random {
+public:
+	Random(unsigned long long seed = 1)
+	{
+		for (unsigned int i = 0; i < 4; i++) {
+			seed += 0x9e3779b97f4a7c15ull;
+			unsigned long long z = seed;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			s[i] = z ^ (z >> 31);
+		}
+	}
+
+	unsigned long long next()
+	{
+		unsigned long long result = rotl(s[1]*5,7)*9;
+		unsigned long long t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3],45);
+		return result;
+	}
+
+	// the threshold for chance() that is true with probability p in
+	// [0,1]; exact at 0 and 1, within 2^-64 elsewhere
+	static unsigned long long threshold(double p)
+	{
+		if (p <= 0) {
+			return 0;
+		}
+		if (p >= 1) {
+			return ~0ull;
+		}
+		return (unsigned long long) (p*18446744073709551616.0);
+	}
+
+	// true with the probability threshold stands for
+	bool chance(unsigned long long threshold)
+	{
+		// ~0 is certainty, not 1-2^-64
+		return next() < threshold || threshold == ~0ull;
+	}
+
+	// uniform in [0,n), by multiply and shift (Lemire), bias < n/2^64
+	unsigned long long below(unsigned long long n)
+	{
+		return (unsigned long long) (((unsigned __int128) next()*n) >> 64);
+	}
+private:
+	static unsigned long long rotl(unsigned long long x,int k)
+	{
+		return (x << k) | (x >> (64-k));
+	}
+
+	unsigned long long s[4];
+};
+
+#endif
@@ -0,0 +1,323 @@
+#include <assert.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "reactor.h"
+
+using namespace std;
+
+// Reactor_shard ----------------------------------------------------------
+
+// one reactor thread and the timers it runs; aligned so that no two
+// shards share a cache line
+struct alignas(64) Reactor_shard {
+	// a heap entry keeps its timer's key, so sifting reads only the heap
+	struct Entry {
+		struct timeval time;
+		unsigned long order; // equal times run in the order set
+		Reactor_timer* timer;
+	};
+
+	pthread_mutex_t mutex; // guards everything below but callbacks
+	vector<Entry> heap; // min-heap on (time,order)
+	unsigned long order;
+	bool running;
+	// attached; read without the lock to pick a shard
+	std::atomic<unsigned int> timers;
+
+	// the timer whose callback is running; detach waits for it on idle
+	Reactor_timer* current;
+	pthread_cond_t idle;
+
+	// the thread is in poll, or about to be; set_timer writes wakeup_fd
+	// only then
+	bool polling;
+	int wakeup_fd;
+
+	pthread_t thread;
+	unsigned int processor;
+	Counter callbacks;
+
+	bool before(const Entry& e0,const Entry& e1)
+	{
+		return e0.time < e1.time
+		 || (e0.time == e1.time && e0.order < e1.order);
+	}
+
+	void place(const Entry& entry,unsigned int index)
+	{
+		heap[index] = entry;
+		entry.timer->index = index;
+	}
+
+	// timers only ever move earlier, or come off the top
+	void sift_up(unsigned int index)
+	{
+		Entry entry = heap[index];
+		while (index > 0 && before(entry,heap[(index-1)/2])) {
+			place(heap[(index-1)/2],index);
+			index = (index-1)/2;
+		}
+		place(entry,index);
+	}
+
+	void sift_down(unsigned int index)
+	{
+		Entry entry = heap[index];
+		unsigned int n = heap.size();
+		while (2*index+1 < n) {
+			unsigned int child = 2*index+1;
+			if (child+1 < n && before(heap[child+1],heap[child])) {
+				child++;
+			}
+			if (!before(heap[child],entry)) {
+				break;
+			}
+			place(heap[child],index);
+			index = child;
+		}
+		place(entry,index);
+	}
+
+	void remove(unsigned int index)
+	{
+		heap[index].timer->index = Reactor_timer::NOT_SCHEDULED;
+		Entry last = heap.back();
+		heap.pop_back();
+		if (index < heap.size()) {
+			place(last,index);
+			sift_up(index);
+			sift_down(last.timer->index);
+		}
+	}
+
+	void wake()
+	{
+		uint64_t one = 1;
+		// a failed write means the counter is saturated: a wakeup is
+		// pending
+		ssize_t n = write(wakeup_fd,&one,sizeof(one));
+		(void) n;
+	}
+};
+
+// Reactor_timer ----------------------------------------------------------
+
+Reactor_timer::Reactor_timer(void (*callback0)(void*),void* arg0)
+{
+	callback = callback0;
+	arg = arg0;
+	shard = NULL;
+	index = NOT_SCHEDULED;
+	detaching = false;
+}
+
+// Reactor ----------------------------------------------------------------
+
+Reactor::Reactor(unsigned int threads)
+{
+	long processors = sysconf(_SC_NPROCESSORS_ONLN);
+	processors = processors > 0 ? processors : 1;
+	if (threads == 0) {
+		threads = processors;
+	}
+
+	for (unsigned int i = 0; i < threads; i++) {
+		Reactor_shard* shard = new Reactor_shard;
+		pthread_mutex_init(&shard->mutex,NULL);
+		pthread_cond_init(&shard->idle,NULL);
+		shard->order = 0;
+		shard->timers.store(0);
+		shard->running = true;
+		shard->current = NULL;
+		shard->polling = false;
+		shard->processor = i % processors;
+		shard->wakeup_fd = eventfd(0,EFD_NONBLOCK);
+		shards.push_back(shard);
+		if (shard->wakeup_fd < 0 || pthread_create(&shard->thread,NULL,
+		 &Reactor::loop,shard) != 0) {
+			// let the threads already started go
+			if (shard->wakeup_fd >= 0) {
+				close(shard->wakeup_fd);
+			}
+			pthread_cond_destroy(&shard->idle);
+			pthread_mutex_destroy(&shard->mutex);
+			delete shard;
+			shards.pop_back();
+			stop();
+			throw Reactor_exception();
+		}
+	}
+}
+
+Reactor::~Reactor()
+{
+	stop();
+}
+
+void Reactor::stop()
+{
+	for (unsigned int i = 0; i < shards.size(); i++) {
+		Reactor_shard* shard = shards[i];
+		pthread_mutex_lock(&shard->mutex);
+		shard->running = false;
+		shard->wake();
+		pthread_mutex_unlock(&shard->mutex);
+	}
+	for (unsigned int i = 0; i < shards.size(); i++) {
+		Reactor_shard* shard = shards[i];
+		pthread_join(shard->thread,NULL);
+		// every link and timer must be gone first: one still attached
+		// would point at the shard freed here
+		assert(shard->timers.load() == 0);
+		close(shard->wakeup_fd);
+		pthread_cond_destroy(&shard->idle);
+		pthread_mutex_destroy(&shard->mutex);
+		delete shard;
+	}
+	shards.clear();
+}
+
+void Reactor::attach(Reactor_timer& timer)
+{
+	// a racing attach or detach at worst evens the shards out a little
+	// less well
+	Reactor_shard* shard = shards[0];
+	for (unsigned int i = 1; i < shards.size(); i++) {
+		if (shards[i]->timers.load() < shard->timers.load()) {
+			shard = shards[i];
+		}
+	}
+	pthread_mutex_lock(&shard->mutex);
+	shard->timers++;
+	timer.shard = shard;
+	timer.index = Reactor_timer::NOT_SCHEDULED;
+	pthread_mutex_unlock(&shard->mutex);
+}
+
+void Reactor::detach(Reactor_timer& timer)
+{
+	Reactor_shard* shard = timer.shard;
+	pthread_mutex_lock(&shard->mutex);
+	if (timer.index != Reactor_timer::NOT_SCHEDULED) {
+		shard->remove(timer.index);
+	}
+	// a callback that sets its own timer again would otherwise be back
+	// on the heap, and run again, before this thread gets the lock back
+	timer.detaching = true;
+	// from its own callback there is nothing to wait for
+	while (shard->current == &timer
+	 && !pthread_equal(pthread_self(),shard->thread)) {
+		pthread_cond_wait(&shard->idle,&shard->mutex);
+	}
+	timer.detaching = false;
+	shard->timers--;
+	timer.shard = NULL;
+	pthread_mutex_unlock(&shard->mutex);
+}
+
+void Reactor::set_timer(Reactor_timer& timer,const struct timeval& time)
+{
+	Reactor_shard* shard = timer.shard;
+	pthread_mutex_lock(&shard->mutex);
+	if (timer.detaching) {
+		pthread_mutex_unlock(&shard->mutex);
+		return;
+	}
+	Reactor_shard::Entry entry;
+	entry.time = time;
+	entry.order = shard->order++;
+	entry.timer = &timer;
+	if (timer.index == Reactor_timer::NOT_SCHEDULED) {
+		shard->heap.push_back(entry);
+		shard->sift_up(shard->heap.size()-1);
+	} else if (shard->before(entry,shard->heap[timer.index])) {
+		shard->heap[timer.index] = entry;
+		shard->sift_up(timer.index);
+	}
+	// the thread sleeps until its earliest timer: cut that short
+	if (timer.index == 0 && shard->polling) {
+		shard->polling = false;
+		shard->wake();
+	}
+	pthread_mutex_unlock(&shard->mutex);
+}
+
+unsigned int Reactor::get_threads() const
+{
+	return shards.size();
+}
+
+unsigned long Reactor::get_callbacks() const
+{
+	unsigned long n = 0;
+	for (unsigned int i = 0; i < shards.size(); i++) {
+		n += shards[i]->callbacks.get();
+	}
+	return n;
+}
+
+void* Reactor::loop(void* shard0)
+{
+	Reactor_shard* shard = (Reactor_shard*) shard0;
+
+	// best effort: unpinned threads still work
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(shard->processor,&cpus);
+	pthread_setaffinity_np(pthread_self(),sizeof(cpus),&cpus);
+
+	struct timeval current;
+	gettimeofday(&current,NULL);
+	pthread_mutex_lock(&shard->mutex);
+	while (shard->running) {
+		// run everything due, taking the clock only when the heap's top
+		// is not due by the last reading
+		if (!shard->heap.empty() && !(current < shard->heap[0].time)) {
+			Reactor_timer* timer = shard->heap[0].timer;
+			shard->remove(0);
+			shard->current = timer;
+			pthread_mutex_unlock(&shard->mutex);
+
+			timer->callback(timer->arg);
+			shard->callbacks.add();
+
+			pthread_mutex_lock(&shard->mutex);
+			shard->current = NULL;
+			pthread_cond_broadcast(&shard->idle);
+			continue;
+		}
+		gettimeofday(&current,NULL);
+		if (!shard->heap.empty() && !(current < shard->heap[0].time)) {
+			continue;
+		}
+
+		struct timespec wait;
+		bool has_deadline = !shard->heap.empty();
+		if (has_deadline) {
+			timeval remaining = shard->heap[0].time-current;
+			wait.tv_sec = remaining.tv_sec;
+			wait.tv_nsec = remaining.tv_usec*1000;
+		}
+		shard->polling = true;
+		pthread_mutex_unlock(&shard->mutex);
+
+		struct pollfd pfd;
+		pfd.fd = shard->wakeup_fd;
+		pfd.events = POLLIN;
+		ppoll(&pfd,1,has_deadline ? &wait : NULL,NULL);
+		// reset the counter; fails harmlessly if woken by the deadline
+		uint64_t count;
+		ssize_t n = read(shard->wakeup_fd,&count,sizeof(count));
+		(void) n;
+
+		gettimeofday(&current,NULL);
+		pthread_mutex_lock(&shard->mutex);
+		shard->polling = false;
+	}
+	pthread_mutex_unlock(&shard->mutex);
+	return NULL;
+}
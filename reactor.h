@@ -0,0 +1,96 @@
+#include <atomic>
+#include <exception>
+#include <vector>
+#include <pthread.h>
+#include "sys/time.h"
+
+#include "metrics.h"
+#include "timeval_operators.h"
+
+#ifndef REACTOR_H
+#define REACTOR_H
+
+using namespace std;
+
+class Reactor;
+
+// Reactor_exception ------------------------------------------------------
+
+class Reactor_exception: public exception {
+};
+
+// Reactor_timer ----------------------------------------------------------
+
+// Work a Reactor runs on one of its threads when it is due: in practice a
+// link's protocol loop, woken whenever the link is. Owned by the caller.
+// attach it to a reactor once, and detach it before destroying it
+class Reactor_timer {
+public:
+	Reactor_timer(void (*callback)(void*),void* arg);
+private:
+	friend class Reactor;
+	friend struct Reactor_shard;
+
+	enum {NOT_SCHEDULED = ~0u};
+
+	void (*callback)(void*);
+	void* arg;
+	struct Reactor_shard* shard; // where it runs; NULL until attached
+	// guarded by the shard's lock: the timer's place in the shard's heap,
+	// and whether detach is waiting for it, which keeps it off the heap
+	unsigned int index;
+	bool detaching;
+};
+
+// Reactor ----------------------------------------------------------------
+
+// A fixed set of threads, each running the timers of a shard of the links
+// attached to it, in real time. A thread sleeps until its earliest timer
+// is due or a timer is moved ahead of it, then runs everything due.
+// Timers stay on the shard they were attached to, so a link's state stays
+// in one thread's cache, and each shard keeps its heap, lock and wakeup
+// on cache lines of its own. Callbacks run without the shard's lock, so
+// they may set any timer, their own included.
+//
+// A shard's lock is the last in the lock order. It is held only over the
+// shard's heap, never while a callback runs or another lock is taken, so
+// set_timer may be called holding any other lock: a link calls it under
+// its own mutex, and from a physical layer's listener under the buffer
+// lock
+class Reactor {
+public:
+	// threads 0 starts one thread per online processor. Thread i runs on
+	// processor i modulo their number. throw Reactor_exception if a thread
+	// cannot be started
+	Reactor(unsigned int threads = 0);
+	// stops and joins the threads. Every link and timer using the
+	// reactor must be destroyed or detached first: a timer still
+	// attached keeps pointing at its freed shard. Debug builds assert it
+	~Reactor();
+
+	// give timer to the shard with the fewest timers
+	void attach(Reactor_timer& timer);
+	// cancel timer, wait for its callback if it is running on another
+	// thread, and take it off its shard. set_timer on it meanwhile, from
+	// the callback or anywhere else, does nothing. Since it may wait, the
+	// caller must hold no lock the callback takes
+	void detach(Reactor_timer& timer);
+
+	// run timer's callback by time: schedule it, or move it earlier if it
+	// is pending later. A time already past runs it as soon as its thread
+	// can, after timers due earlier still. Any thread may call it
+	void set_timer(Reactor_timer& timer,const struct timeval& time);
+
+	unsigned int get_threads() const;
+	unsigned long get_callbacks() const; // run so far, by every thread
+private:
+	Reactor(const Reactor&);
+	Reactor& operator=(const Reactor&);
+
+	static void* loop(void* shard);
+	void stop();
+
+	vector<struct Reactor_shard*> shards;
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include <atomic>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "reactor.h"
+
+using namespace std;
+
+// Reactor test: attach and detach timers while callbacks run. detach must
+// not return while its timer's callback is still running on a reactor
+// thread, even one that sets its own timer again, and no callback may run
+// after it returns. A callback may detach its own timer. Timers attached
+// and detached over and over beside busy ones must each run when set, on
+// every shard. At the end every timer is detached, so ~Reactor's debug
+// check passes.
+
+const unsigned int THREADS = 2;
+const unsigned int BUSY = 4; // timers that set themselves again forever
+const unsigned int BUSY_PERIOD = 100; // microseconds
+const unsigned int ROUNDS = 500;
+const unsigned int CALLBACK_TIME = 20000; // microseconds
+const unsigned int TIME_LIMIT = 10; // seconds to wait for anything
+
+Reactor* reactor;
+bool failed = false;
+
+struct timeval now()
+{
+	struct timeval t;
+	gettimeofday(&t,NULL);
+	return t;
+}
+
+// wait up to TIME_LIMIT for flag to be set
+bool wait_for(const atomic<bool>& flag)
+{
+	struct timeval deadline = now()+usec_to_timeval(TIME_LIMIT*1000000ul);
+	while (!flag.load()) {
+		if (deadline < now()) {
+			return false;
+		}
+		sched_yield();
+	}
+	return true;
+}
+
+// a timer whose callback takes a while, and may set itself again
+struct Slow {
+	Reactor_timer timer;
+	bool again;
+	atomic<bool> started;
+	atomic<bool> running;
+	atomic<unsigned long> calls;
+
+	Slow(bool again0) : timer(&callback,this), again(again0),
+	 started(false), running(false), calls(0) {}
+
+	static void callback(void* slow0)
+	{
+		Slow* slow = (Slow*) slow0;
+		slow->running = true;
+		slow->started = true;
+		usleep(CALLBACK_TIME);
+		slow->calls++;
+		if (slow->again) {
+			reactor->set_timer(slow->timer,now());
+		}
+		slow->running = false;
+	}
+};
+
+struct Detach {
+	Reactor_timer* timer;
+	atomic<bool> done;
+};
+
+void* detach(void* detach0)
+{
+	Detach* d = (Detach*) detach0;
+	reactor->detach(*d->timer);
+	d->done = true;
+	return NULL;
+}
+
+void detach_while_running(bool again)
+{
+	const char* what = again ? "self-setting timer" : "timer";
+	Slow slow(again);
+	reactor->attach(slow.timer);
+	reactor->set_timer(slow.timer,now());
+	if (!wait_for(slow.started)) {
+		cout << "FAIL: the " << what << " never ran" << endl;
+		exit(1);
+	}
+	// on a thread of its own, so that a detach that never returns fails
+	Detach d;
+	d.timer = &slow.timer;
+	d.done = false;
+	pthread_t thread;
+	pthread_create(&thread,NULL,&detach,&d);
+	if (!wait_for(d.done)) {
+		cout << "FAIL: detach of the " << what << " never returned"
+		 << endl;
+		exit(1);
+	}
+	pthread_join(thread,NULL);
+	if (slow.running.load()) {
+		cout << "FAIL: detach returned while the " << what
+		 << "'s callback ran" << endl;
+		failed = true;
+	}
+	unsigned long calls = slow.calls.load();
+	usleep(5*CALLBACK_TIME);
+	if (slow.calls.load() != calls) {
+		cout << "FAIL: the " << what << " ran after detach" << endl;
+		failed = true;
+	}
+}
+
+// a timer that detaches itself from its own callback
+struct Self_detaching {
+	Reactor_timer timer;
+	atomic<bool> done;
+
+	Self_detaching() : timer(&callback,this), done(false) {}
+
+	static void callback(void* self0)
+	{
+		Self_detaching* self = (Self_detaching*) self0;
+		reactor->detach(self->timer);
+		self->done = true;
+	}
+};
+
+// a timer that keeps its shard's thread running callbacks
+struct Busy {
+	Reactor_timer timer;
+	atomic<unsigned long> calls;
+
+	Busy() : timer(&callback,this), calls(0) {}
+
+	static void callback(void* busy0)
+	{
+		Busy* busy = (Busy*) busy0;
+		busy->calls++;
+		reactor->set_timer(busy->timer,
+		 now()+usec_to_timeval(BUSY_PERIOD));
+	}
+};
+
+// a timer set once per attach
+struct Once {
+	Reactor_timer timer;
+	atomic<bool> ran;
+
+	Once() : timer(&callback,this), ran(false) {}
+
+	static void callback(void* once0)
+	{
+		((Once*) once0)->ran = true;
+	}
+};
+
+int main(int argc,char* argv[])
+{
+	reactor = new Reactor(THREADS);
+
+	detach_while_running(false);
+	detach_while_running(true);
+
+	Self_detaching self;
+	reactor->attach(self.timer);
+	reactor->set_timer(self.timer,now());
+	if (!wait_for(self.done)) {
+		cout << "FAIL: a timer could not detach itself" << endl;
+		return 1;
+	}
+
+	// attach, set, run and detach beside timers that never stop, a
+	// timer per shard at a time: attach picks the shard with the fewest
+	Busy busy[BUSY];
+	for (unsigned int i = 0; i < BUSY; i++) {
+		reactor->attach(busy[i].timer);
+		reactor->set_timer(busy[i].timer,now());
+	}
+	for (unsigned int i = 0; i < ROUNDS; i++) {
+		// the first goes to shard 0, the second to the other
+		Once once[THREADS];
+		for (unsigned int j = 0; j < THREADS; j++) {
+			reactor->attach(once[j].timer);
+			reactor->set_timer(once[j].timer,now());
+		}
+		for (unsigned int j = 0; j < THREADS; j++) {
+			if (!wait_for(once[j].ran)) {
+				cout << "FAIL: a timer attached in round " << i
+				 << " never ran" << endl;
+				return 1;
+			}
+			reactor->detach(once[j].timer);
+		}
+	}
+	for (unsigned int i = 0; i < BUSY; i++) {
+		reactor->detach(busy[i].timer);
+		if (busy[i].calls.load() == 0) {
+			cout << "FAIL: busy timer " << i << " never ran"
+			 << endl;
+			failed = true;
+		}
+	}
+
+	delete reactor;
+	if (failed) {
+		return 1;
+	}
+	cout << "ok" << endl;
+	return 0;
+}
@@ -0,0 +1,54 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "replay.h"
+
+using namespace std;
+
+// Replay -----------------------------------------------------------------
+
+Replay::Replay(const char* path)
+{
+	int fd = open(path,O_RDONLY);
+	if (fd < 0) {
+		throw Replay_exception();
+	}
+	struct stat st;
+	if (fstat(fd,&st) != 0
+	 || (size_t) st.st_size < sizeof(Replay_file_header)) {
+		close(fd);
+		throw Replay_exception();
+	}
+	map_length = st.st_size;
+	void* p = mmap(NULL,map_length,PROT_READ,MAP_SHARED,fd,0);
+	// the mapping keeps the file open
+	close(fd);
+	if (p == MAP_FAILED) {
+		throw Replay_exception();
+	}
+	map = (char*) p;
+
+	const Replay_file_header* header = (const Replay_file_header*) map;
+	length = header->events;
+	if (memcmp(header->magic,REPLAY_MAGIC,sizeof(REPLAY_MAGIC)) != 0
+	 || header->version != REPLAY_VERSION
+	 || header->record_length != sizeof(unsigned int)
+	 || length == 0
+	 || length > (map_length-sizeof(Replay_file_header))
+	 /sizeof(unsigned int)) {
+		munmap(map,map_length);
+		throw Replay_exception();
+	}
+	events = (const unsigned int*) (map+sizeof(Replay_file_header));
+	page_size = sysconf(_SC_PAGESIZE);
+
+	// read ahead of the readers, and drop pages behind them first
+	madvise(map,map_length,MADV_SEQUENTIAL);
+}
+
+Replay::~Replay()
+{
+	munmap(map,map_length);
+}
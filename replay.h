@@ -0,0 +1,86 @@
+#include <exception>
+#include <stddef.h>
+#include <sys/mman.h>
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+using namespace std;
+
+// Replay_exception -------------------------------------------------------
+
+class Replay_exception: public exception {
+};
+
+// replay file ------------------------------------------------------------
+
+// one frame's fate, 4 bytes: its delay in microseconds in the low 30 bits,
+// then whether it was corrupted and whether it was dropped
+enum {REPLAY_DELAY_MASK = (1u << 30)-1, REPLAY_CORRUPTED = 1u << 30,
+ REPLAY_DROPPED = 1u << 31};
+
+// a replay file: this header, then its events, one per frame sent
+struct Replay_file_header {
+	char magic[8]; // REPLAY_MAGIC
+	unsigned int version;
+	unsigned int record_length; // sizeof(unsigned int)
+	unsigned long long events;
+};
+
+#define REPLAY_MAGIC "LLREPLY"
+enum {REPLAY_VERSION = 1};
+
+// Replay -----------------------------------------------------------------
+
+// A replay file, memory-mapped read-only for Impairs to draw their frames'
+// fates from. Mapping is all opening does, so a file of any size opens at
+// once; pages are read in as replay reaches them, read ahead of it, and
+// released behind it, so a long replay holds a window of the file in
+// memory rather than all of it. Readers keep their own positions, so
+// several Impairs can share one Replay
+class Replay {
+public:
+	// events between releases of the pages behind a reader: 1 MiB
+	enum {RELEASE_EVENTS = 1 << 18};
+
+	// throw Replay_exception if path is not a version REPLAY_VERSION
+	// replay file with at least one event
+	Replay(const char* path);
+	~Replay();
+
+	unsigned long long get_length() const
+	{
+		return length;
+	}
+
+	// event i < get_length()
+	unsigned int get_event(unsigned long long i) const
+	{
+		return events[i];
+	}
+
+	// a reader is done with events [from,to): drop the whole pages they
+	// fill from this process. Another reader still behind them faults
+	// them back in from the page cache
+	void release(unsigned long long from,unsigned long long to) const
+	{
+		size_t begin = (size_t) ((const char*) &events[from]-map);
+		size_t end = (size_t) ((const char*) &events[to]-map);
+		begin = (begin+page_size-1)/page_size*page_size;
+		end = end/page_size*page_size;
+		if (begin < end) {
+			madvise(map+begin,end-begin,MADV_DONTNEED);
+		}
+	}
+private:
+	Replay(const Replay&);
+	Replay& operator=(const Replay&);
+
+	char* map;
+	size_t map_length;
+	size_t page_size;
+	const unsigned int* events;
+	unsigned long long length;
+};
+
+#endif
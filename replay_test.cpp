@@ -0,0 +1,208 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "physical_layer.h"
+#include "replay.h"
+#include "simulator.h"
+#include "timeval_operators.h"
+
+using namespace std;
+
+// Replay test: writes a small replay file by hand and checks that every
+// event decodes to the fate it records - the delay in the low 30 bits,
+// REPLAY_CORRUPTED and REPLAY_DROPPED above it - first as Replay returns
+// the events, then as frames sent through a Physical_layer on a
+// Simulator meet them, from an event past the first and round the end of
+// the file again. Files with a bad header or fewer events than they
+// claim must not open.
+
+const unsigned int EVENTS[] = {
+	1234,
+	REPLAY_CORRUPTED | 500,
+	REPLAY_DROPPED,
+	REPLAY_DROPPED | REPLAY_CORRUPTED | REPLAY_DELAY_MASK,
+	0,
+	REPLAY_DELAY_MASK,
+	REPLAY_CORRUPTED,
+	7
+};
+const unsigned int NUM_EVENTS = sizeof(EVENTS)/sizeof(EVENTS[0]);
+const unsigned int START = 2; // first event the Impair draws
+const unsigned int FRAMES = 3*NUM_EVENTS;
+const unsigned int LENGTH = 40;
+
+bool failed = false;
+
+void fail(const char* what,unsigned int i)
+{
+	cout << "FAIL: " << what << " at event " << i << endl;
+	failed = true;
+}
+
+// write header, then events; store the file's name in path
+void write_file(char* path,const Replay_file_header& header,
+ const unsigned int events[],unsigned int num_events)
+{
+	strcpy(path,"/tmp/replay_test.XXXXXX");
+	int fd = mkstemp(path);
+	if (fd < 0
+	 || write(fd,&header,sizeof(header)) != (ssize_t) sizeof(header)
+	 || write(fd,events,num_events*sizeof(unsigned int))
+	 != (ssize_t) (num_events*sizeof(unsigned int))) {
+		cout << "FAIL: cannot write " << path << endl;
+		exit(1);
+	}
+	close(fd);
+}
+
+Replay_file_header make_header(unsigned long long events)
+{
+	Replay_file_header header;
+	memset(&header,0,sizeof(header));
+	memcpy(header.magic,REPLAY_MAGIC,sizeof(REPLAY_MAGIC));
+	header.version = REPLAY_VERSION;
+	header.record_length = sizeof(unsigned int);
+	header.events = events;
+	return header;
+}
+
+// a file with header that Replay must refuse
+void check_rejected(const char* what,const Replay_file_header& header)
+{
+	char path[32];
+	write_file(path,header,EVENTS,NUM_EVENTS);
+	try {
+		Replay replay(path);
+		cout << "FAIL: opened a file with " << what << endl;
+		failed = true;
+	} catch (Replay_exception&) {
+	}
+	unlink(path);
+}
+
+// the events as Replay returns them
+void check_events(const Replay& replay)
+{
+	if (replay.get_length() != NUM_EVENTS) {
+		cout << "FAIL: " << replay.get_length() << " events, not "
+		 << NUM_EVENTS << endl;
+		exit(1);
+	}
+	for (unsigned int i = 0; i < NUM_EVENTS; i++) {
+		if (replay.get_event(i) != EVENTS[i]) {
+			fail("wrong event",i);
+		}
+	}
+	if ((EVENTS[1] & REPLAY_DELAY_MASK) != 500
+	 || (EVENTS[3] & REPLAY_DELAY_MASK) != (1u << 30)-1
+	 || (REPLAY_DELAY_MASK & (REPLAY_CORRUPTED | REPLAY_DROPPED)) != 0
+	 || REPLAY_CORRUPTED == REPLAY_DROPPED) {
+		cout << "FAIL: the event fields overlap" << endl;
+		failed = true;
+	}
+}
+
+// frames sent a -> b, each meeting the next event from START on
+void check_frames(const Replay& replay)
+{
+	Simulator simulator;
+	Impair a_impair;
+	Impair b_impair;
+	a_impair.set_replay(&replay,START);
+	Physical_layer physical_layer(a_impair,b_impair,NULL,NULL,1,0,
+	 &simulator);
+	Physical_layer_interface* a = physical_layer.get_a_interface();
+	Physical_layer_interface* b = physical_layer.get_b_interface();
+
+	unsigned char sent[LENGTH];
+	unsigned char received[Physical_layer_interface::MAXIMUM_BUFFER_LENGTH];
+	for (unsigned int f = 0; f < FRAMES; f++) {
+		unsigned int i = (START+f) % NUM_EVENTS;
+		unsigned int event = EVENTS[i];
+		struct timeval sent_at = simulator.now();
+		memset(sent,f,sizeof(sent));
+		if (a->send(sent,LENGTH) <= 0) {
+			fail("send refused",i);
+			return;
+		}
+
+		struct timeval release_time;
+		bool in_flight = b->get_release_time(release_time);
+		if (in_flight == ((event & REPLAY_DROPPED) != 0)) {
+			fail(in_flight ? "dropped frame sent" : "frame lost",i);
+			continue;
+		}
+		if (!in_flight) {
+			continue;
+		}
+		if (release_time != sent_at+usec_to_timeval(event
+		 & REPLAY_DELAY_MASK)) {
+			fail("wrong delay",i);
+		}
+		simulator.run_until(release_time);
+		if (b->receive(received) != LENGTH) {
+			fail("frame not received",i);
+			continue;
+		}
+		bool corrupted = memcmp(sent,received,LENGTH) != 0;
+		if (corrupted != ((event & REPLAY_CORRUPTED) != 0)) {
+			fail(corrupted ? "frame corrupted" : "frame intact",i);
+		}
+	}
+
+	Physical_layer_metrics metrics = a->get_metrics();
+	unsigned long dropped = 0;
+	unsigned long corrupted = 0;
+	for (unsigned int f = 0; f < FRAMES; f++) {
+		unsigned int event = EVENTS[(START+f) % NUM_EVENTS];
+		dropped += (event & REPLAY_DROPPED) != 0;
+		corrupted += (event & REPLAY_CORRUPTED) != 0;
+	}
+	if (metrics.dropped != dropped || metrics.corrupted != corrupted) {
+		cout << "FAIL: " << metrics.dropped << " dropped and "
+		 << metrics.corrupted << " corrupted counted, not " << dropped
+		 << " and " << corrupted << endl;
+		failed = true;
+	}
+}
+
+int main(int argc,char* argv[])
+{
+	char path[32];
+	write_file(path,make_header(NUM_EVENTS),EVENTS,NUM_EVENTS);
+	Replay* replay;
+	try {
+		replay = new Replay(path);
+	} catch (Replay_exception&) {
+		cout << "FAIL: cannot open " << path << endl;
+		unlink(path);
+		return 1;
+	}
+	// the mapping outlives the name
+	unlink(path);
+
+	check_events(*replay);
+	check_frames(*replay);
+	delete replay;
+
+	Replay_file_header header = make_header(NUM_EVENTS);
+	header.magic[0] = 'X';
+	check_rejected("a bad magic",header);
+	header = make_header(NUM_EVENTS);
+	header.version = REPLAY_VERSION+1;
+	check_rejected("a later version",header);
+	header = make_header(NUM_EVENTS);
+	header.record_length = 8;
+	check_rejected("8-byte records",header);
+	check_rejected("no events",make_header(0));
+	check_rejected("more events than it holds",make_header(NUM_EVENTS+1));
+
+	if (failed) {
+		return 1;
+	}
+	cout << "ok" << endl;
+	return 0;
+}
@@ -0,0 +1,206 @@
+#include "simulator.h"
+
+// Real_clock -------------------------------------------------------------
+
+struct timeval Real_clock::now(void)
+{
+	struct timeval t;
+	gettimeofday(&t,NULL);
+	return t;
+}
+
+// Simulator_timer --------------------------------------------------------
+
+Simulator_timer::Simulator_timer(void (*callback0)(void*),void* arg0)
+{
+	callback = callback0;
+	arg = arg0;
+	time.tv_sec = 0;
+	time.tv_usec = 0;
+	order = 0;
+	index = NOT_SCHEDULED;
+	one_shot = false;
+}
+
+bool Simulator_timer::is_scheduled(void) const
+{
+	return index != NOT_SCHEDULED;
+}
+
+struct timeval Simulator_timer::get_time(void) const
+{
+	return time;
+}
+
+// Simulator --------------------------------------------------------------
+
+Simulator::Simulator()
+{
+	event_order = 0;
+	event_count = 0;
+	current.tv_sec = 0;
+	current.tv_usec = 0;
+}
+
+Simulator::~Simulator()
+{
+	for (unsigned int i = 0; i < events.size(); i++) {
+		events[i].timer->index = Simulator_timer::NOT_SCHEDULED;
+		if (events[i].timer->one_shot) {
+			delete events[i].timer;
+		}
+	}
+}
+
+struct timeval Simulator::now(void)
+{
+	return current;
+}
+
+void Simulator::schedule(const struct timeval& time,
+ void (*callback)(void*),void* arg)
+{
+	Simulator_timer* timer = new Simulator_timer(callback,arg);
+	timer->one_shot = true;
+	set_timer(*timer,time);
+}
+
+void Simulator::cancel(void* arg)
+{
+	unsigned int i = 0;
+	while (i < events.size()) {
+		Simulator_timer* timer = events[i].timer;
+		if (!timer->one_shot || timer->arg != arg) {
+			i++;
+			continue;
+		}
+		// the last entry moves to i and is sifted. Sifted down, it
+		// stays among the entries not looked at yet; sifted up, it
+		// passes entries already looked at, so go back to it if it is
+		// to be cancelled too
+		Simulator_timer* moved = events.back().timer;
+		remove(i);
+		delete timer;
+		if (moved != timer && moved->index < i
+		 && moved->one_shot && moved->arg == arg) {
+			i = moved->index;
+		}
+	}
+}
+
+void Simulator::set_timer(Simulator_timer& timer,const struct timeval& time)
+{
+	Entry entry;
+	entry.time = time < current ? current : time;
+	entry.order = event_order++;
+	entry.timer = &timer;
+	timer.time = entry.time;
+	timer.order = entry.order;
+	if (!timer.is_scheduled()) {
+		events.push_back(entry);
+		timer.index = events.size()-1;
+	} else {
+		events[timer.index] = entry;
+	}
+	// it may have moved either way
+	sift_up(timer.index);
+	sift_down(timer.index);
+}
+
+void Simulator::cancel_timer(Simulator_timer& timer)
+{
+	if (timer.is_scheduled()) {
+		remove(timer.index);
+	}
+}
+
+bool Simulator::step(void)
+{
+	if (events.empty()) {
+		return false;
+	}
+
+	// the callback may schedule more events, so take this one off first
+	Simulator_timer* timer = events[0].timer;
+	remove(0);
+	current = timer->time;
+	event_count++;
+	if (timer->one_shot) {
+		void (*callback)(void*) = timer->callback;
+		void* arg = timer->arg;
+		delete timer;
+		callback(arg);
+	} else {
+		timer->callback(timer->arg);
+	}
+
+	return true;
+}
+
+void Simulator::run_until(const struct timeval& until)
+{
+	while (!events.empty() && events[0].time <= until) {
+		step();
+	}
+	if (current < until) {
+		current = until;
+	}
+}
+
+unsigned long Simulator::get_event_count(void)
+{
+	return event_count;
+}
+
+bool Simulator::before(const Entry& e0,const Entry& e1)
+{
+	return e0.time < e1.time || (e0.time == e1.time && e0.order < e1.order);
+}
+
+void Simulator::place(const Entry& entry,unsigned int index)
+{
+	events[index] = entry;
+	entry.timer->index = index;
+}
+
+void Simulator::sift_up(unsigned int index)
+{
+	Entry entry = events[index];
+	while (index > 0 && before(entry,events[(index-1)/2])) {
+		place(events[(index-1)/2],index);
+		index = (index-1)/2;
+	}
+	place(entry,index);
+}
+
+void Simulator::sift_down(unsigned int index)
+{
+	Entry entry = events[index];
+	unsigned int size = events.size();
+	while (2*index+1 < size) {
+		unsigned int child = 2*index+1;
+		if (child+1 < size && before(events[child+1],events[child])) {
+			child++;
+		}
+		if (!before(events[child],entry)) {
+			break;
+		}
+		place(events[child],index);
+		index = child;
+	}
+	place(entry,index);
+}
+
+// take the timer at index off the heap, keeping its memory
+void Simulator::remove(unsigned int index)
+{
+	Simulator_timer* timer = events[index].timer;
+	Entry last = events.back();
+	events.pop_back();
+	if (last.timer != timer) {
+		place(last,index);
+		sift_up(index);
+		sift_down(last.timer->index);
+	}
+	timer->index = Simulator_timer::NOT_SCHEDULED;
+}
@@ -0,0 +1,116 @@
+#include <vector>
+#include "sys/time.h"
+
+#include "timeval_operators.h"
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+using namespace std;
+
+class Simulator;
+
+// Clock ------------------------------------------------------------------
+
+// time source for the physical and link layers
+class Clock {
+public:
+	virtual ~Clock() {}
+	virtual struct timeval now(void) = 0;
+};
+
+// wall-clock time; used when no Simulator is given
+class Real_clock: public Clock {
+public:
+	struct timeval now(void);
+};
+
+// Simulator_timer --------------------------------------------------------
+
+// An event the owner can move or cancel while it is pending: at most one
+// instance of it is ever scheduled, so an owner that keeps changing its
+// mind about when to run costs the simulator one entry, not one per
+// change. Owned by the caller; cancel it before destroying it
+class Simulator_timer {
+public:
+	Simulator_timer(void (*callback)(void*),void* arg);
+
+	bool is_scheduled(void) const;
+
+	// valid while is_scheduled
+	struct timeval get_time(void) const;
+private:
+	friend class Simulator;
+
+	enum {NOT_SCHEDULED = ~0u};
+
+	void (*callback)(void*);
+	void* arg;
+	struct timeval time;
+	unsigned long order; // equal times run in the order they were set
+	unsigned int index; // position in the simulator's heap
+	bool one_shot; // allocated by Simulator::schedule, freed once run
+};
+
+// Simulator --------------------------------------------------------------
+
+// Discrete-event scheduler on a virtual clock. Time stands still while an
+// event runs and jumps to the next event when it returns, so a run
+// depends only on its inputs, never on the host's speed or scheduler.
+// Layers built on a Simulator start no threads: they, and the
+// application driving them, run on the thread that calls step().
+// Not thread-safe.
+class Simulator: public Clock {
+public:
+	Simulator();
+	~Simulator();
+
+	// virtual time, starting at 0
+	struct timeval now(void);
+
+	// call callback(arg) once at time, or now if time has passed
+	void schedule(const struct timeval& time,void (*callback)(void*),
+	 void* arg);
+
+	// drop every pending schedule()d event for arg
+	void cancel(void* arg);
+
+	// run timer at time, or now if time has passed, moving it if it is
+	// already pending
+	void set_timer(Simulator_timer& timer,const struct timeval& time);
+	void cancel_timer(Simulator_timer& timer);
+
+	// advance to the earliest pending event and run it; return false,
+	// leaving the clock alone, if there is none
+	bool step(void);
+
+	// run every event due up to until, then advance the clock to until
+	void run_until(const struct timeval& until);
+
+	// number of events run so far
+	unsigned long get_event_count(void);
+private:
+	Simulator(const Simulator&);
+	Simulator& operator=(const Simulator&);
+
+	// a heap entry keeps its timer's key, so sifting reads only the heap
+	struct Entry {
+		struct timeval time;
+		unsigned long order;
+		Simulator_timer* timer;
+	};
+
+	bool before(const Entry& e0,const Entry& e1);
+	void place(const Entry& entry,unsigned int index);
+	void sift_up(unsigned int index);
+	void sift_down(unsigned int index);
+	void remove(unsigned int index);
+
+	// min-heap on (time,order); each timer knows its index
+	vector<Entry> events;
+	unsigned long event_order;
+	unsigned long event_count;
+	struct timeval current;
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include <atomic>
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+// Spsc_ring --------------------------------------------------------------
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. The producer fills back() in place and publishes it with push();
+// the consumer reads front() in place and releases it with pop().
+template <class T>
+class Spsc_ring {
+public:
+	// capacity is rounded up to a power of two
+	Spsc_ring(unsigned int capacity)
+	{
+		size = 1;
+		while (size < capacity) {
+			size *= 2;
+		}
+		slots = new T[size];
+		head.store(0,std::memory_order_relaxed);
+		tail.store(0,std::memory_order_relaxed);
+		cached_head = 0;
+		cached_tail = 0;
+	}
+
+	~Spsc_ring()
+	{
+		delete[] slots;
+	}
+
+	unsigned int capacity() const
+	{
+		return size;
+	}
+
+	// ***** producer *****
+
+	// slot to fill, or NULL if the ring is full
+	T* back()
+	{
+		unsigned int t = tail.load(std::memory_order_relaxed);
+		if (t - cached_head == size) {
+			cached_head = head.load(std::memory_order_acquire);
+			if (t - cached_head == size) {
+				return NULL;
+			}
+		}
+		return &slots[t & (size-1)];
+	}
+
+	// publish the slot returned by back()
+	void push()
+	{
+		tail.store(tail.load(std::memory_order_relaxed)+1,
+		 std::memory_order_release);
+	}
+
+	// slots back() can still hand out
+	unsigned int space()
+	{
+		cached_head = head.load(std::memory_order_acquire);
+		return size - (tail.load(std::memory_order_relaxed) - cached_head);
+	}
+
+	bool full() const
+	{
+		return tail.load(std::memory_order_relaxed)
+		 - head.load(std::memory_order_seq_cst) == size;
+	}
+
+	// ***** consumer *****
+
+	// oldest published slot, or NULL if the ring is empty
+	T* front()
+	{
+		unsigned int h = head.load(std::memory_order_relaxed);
+		if (h == cached_tail) {
+			cached_tail = tail.load(std::memory_order_acquire);
+			if (h == cached_tail) {
+				return NULL;
+			}
+		}
+		return &slots[h & (size-1)];
+	}
+
+	// i-th oldest published slot (front() is at(0)), or NULL if fewer
+	// than i+1 are published; lets the consumer work on slots in place
+	// before releasing them in order
+	T* at(unsigned int i)
+	{
+		unsigned int h = head.load(std::memory_order_relaxed);
+		if (cached_tail-h <= i) {
+			cached_tail = tail.load(std::memory_order_acquire);
+			if (cached_tail-h <= i) {
+				return NULL;
+			}
+		}
+		return &slots[(h+i) & (size-1)];
+	}
+
+	// release the slot returned by front()
+	void pop()
+	{
+		head.store(head.load(std::memory_order_relaxed)+1,
+		 std::memory_order_release);
+	}
+
+	// the oldest published slots that lie contiguous in memory, up to the
+	// end of the buffer: store the first in first and return how many,
+	// or return 0 if the ring is empty. Release them with pop(n)
+	unsigned int front_run(T*& first)
+	{
+		unsigned int h = head.load(std::memory_order_relaxed);
+		cached_tail = tail.load(std::memory_order_acquire);
+		unsigned int n = cached_tail-h;
+		unsigned int to_end = size-(h & (size-1));
+		first = &slots[h & (size-1)];
+		return n < to_end ? n : to_end;
+	}
+
+	void pop(unsigned int n)
+	{
+		head.store(head.load(std::memory_order_relaxed)+n,
+		 std::memory_order_release);
+	}
+
+	bool empty() const
+	{
+		return head.load(std::memory_order_relaxed)
+		 == tail.load(std::memory_order_seq_cst);
+	}
+private:
+	Spsc_ring(const Spsc_ring&);
+	Spsc_ring& operator=(const Spsc_ring&);
+
+	T* slots;
+	unsigned int size;
+
+	// head is written only by the consumer and tail only by the producer;
+	// each side keeps a cached copy of the other's index on its own line
+	alignas(64) std::atomic<unsigned int> head;
+	unsigned int cached_tail;
+	alignas(64) std::atomic<unsigned int> tail;
+	unsigned int cached_head;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+
+#include "spsc_ring.h"
+
+using namespace std;
+
+// Spsc_ring test: a ring of 5 (so 8) slots is filled and drained part way
+// many times over, so that its indexes wrap the buffer at every offset,
+// checking every slot, at(), front_run() and the full and empty tests
+// along the way. Then a producer and a consumer thread pass a million
+// numbers through a small ring, which must arrive in order.
+
+const unsigned int ROUNDS = 1000;
+const unsigned int STREAM = 1000000;
+
+Spsc_ring<unsigned int> stream_ring(16);
+
+void* produce(void* arg)
+{
+	for (unsigned int i = 0; i < STREAM; ) {
+		unsigned int* slot = stream_ring.back();
+		if (slot == NULL) {
+			sched_yield();
+			continue;
+		}
+		*slot = i++;
+		stream_ring.push();
+	}
+	return NULL;
+}
+
+int main(int argc,char* argv[])
+{
+	Spsc_ring<unsigned int> ring(5);
+	if (ring.capacity() != 8) {
+		cout << "FAIL: capacity " << ring.capacity() << endl;
+		return 1;
+	}
+
+	// batches of 1 to 5 on top of the 0 to 3 slots left by the last round
+	// move the start of the queued run by a different amount each round
+	unsigned int pushed = 0;
+	unsigned int popped = 0;
+	for (unsigned int round = 0; round < ROUNDS; round++) {
+		unsigned int batch = round % 5 + 1;
+		for (unsigned int i = 0; i < batch; i++) {
+			unsigned int* slot = ring.back();
+			if (slot == NULL) {
+				cout << "FAIL: full with " << pushed-popped
+				 << " queued" << endl;
+				return 1;
+			}
+			*slot = pushed++;
+			ring.push();
+		}
+		if (ring.space() != 8-(pushed-popped)) {
+			cout << "FAIL: space " << ring.space() << " with "
+			 << pushed-popped << " queued" << endl;
+			return 1;
+		}
+		for (unsigned int i = 0; i < pushed-popped; i++) {
+			if (ring.at(i) == NULL || *ring.at(i) != popped+i) {
+				cout << "FAIL: at(" << i << ") in round "
+				 << round << endl;
+				return 1;
+			}
+		}
+		if (ring.at(pushed-popped) != NULL) {
+			cout << "FAIL: at() past the newest slot" << endl;
+			return 1;
+		}
+
+		// top up to full: back() must refuse one more
+		while (pushed-popped < 8) {
+			*ring.back() = pushed++;
+			ring.push();
+		}
+		if (!ring.full() || ring.back() != NULL) {
+			cout << "FAIL: not full in round " << round << endl;
+			return 1;
+		}
+
+		// drain all but (round % 4) slots, alternately one at a time
+		// and by contiguous runs, which stop at the end of the buffer
+		while (pushed-popped > round % 4) {
+			if (round % 2 == 0) {
+				unsigned int* slot = ring.front();
+				if (slot == NULL || *slot != popped) {
+					cout << "FAIL: front() in round "
+					 << round << endl;
+					return 1;
+				}
+				ring.pop();
+				popped++;
+				continue;
+			}
+			// a run stops at the newest slot or the buffer's end
+			unsigned int* first;
+			unsigned int n = ring.front_run(first);
+			unsigned int queued = pushed-popped;
+			unsigned int to_end = 8-popped % 8;
+			if (n != (queued < to_end ? queued : to_end)) {
+				cout << "FAIL: front_run() gave " << n << " of "
+				 << queued << endl;
+				return 1;
+			}
+			for (unsigned int i = 0; i < n; i++) {
+				if (first[i] != popped+i) {
+					cout << "FAIL: front_run() in round "
+					 << round << endl;
+					return 1;
+				}
+			}
+			if (n > queued-round % 4) {
+				n = queued-round % 4;
+			}
+			ring.pop(n);
+			popped += n;
+		}
+	}
+	while (!ring.empty()) {
+		ring.pop();
+		popped++;
+	}
+	if (ring.front() != NULL || pushed != popped) {
+		cout << "FAIL: not empty at the end" << endl;
+		return 1;
+	}
+
+	pthread_t producer;
+	pthread_create(&producer,NULL,&produce,NULL);
+	for (unsigned int i = 0; i < STREAM; ) {
+		unsigned int* slot = stream_ring.front();
+		if (slot == NULL) {
+			sched_yield();
+			continue;
+		}
+		if (*slot != i) {
+			cout << "FAIL: got " << *slot << " for " << i << endl;
+			return 1;
+		}
+		stream_ring.pop();
+		i++;
+	}
+	pthread_join(producer,NULL);
+	cout << "ok" << endl;
+	return 0;
+}
@@ -0,0 +1,190 @@
+#include <unistd.h>
+
+#include "thread_pool.h"
+
+using namespace std;
+
+// the worker the calling thread is, if it is one
+static __thread void* current_worker = NULL;
+
+// Thread_pool ------------------------------------------------------------
+
+Thread_pool::Thread_pool(unsigned int threads)
+{
+	if (threads == 0) {
+		long processors = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = processors > 0 ? processors : 1;
+	}
+	next_worker.store(0);
+	queued.store(0);
+	unfinished.store(0);
+	running = true;
+	pthread_mutex_init(&mutex,NULL);
+	pthread_cond_init(&work,NULL);
+	pthread_cond_init(&done,NULL);
+
+	// every deque exists before any thread can steal from it
+	for (unsigned int i = 0; i < threads; i++) {
+		Worker* worker = new Worker;
+		worker->pool = this;
+		worker->index = i;
+		pthread_mutex_init(&worker->mutex,NULL);
+		workers.push_back(worker);
+	}
+	for (unsigned int i = 0; i < threads; i++) {
+		if (pthread_create(&workers[i]->thread,NULL,&Thread_pool::loop,
+		 workers[i]) != 0) {
+			// let the threads already started go
+			for (unsigned int j = i; j < threads; j++) {
+				pthread_mutex_destroy(&workers[j]->mutex);
+				delete workers[j];
+			}
+			workers.resize(i);
+			stop();
+			throw Thread_pool_exception();
+		}
+	}
+}
+
+Thread_pool::~Thread_pool()
+{
+	wait();
+	stop();
+}
+
+// stop and join the threads in workers, then free everything
+void Thread_pool::stop()
+{
+	pthread_mutex_lock(&mutex);
+	running = false;
+	pthread_cond_broadcast(&work);
+	pthread_mutex_unlock(&mutex);
+	for (unsigned int i = 0; i < workers.size(); i++) {
+		pthread_join(workers[i]->thread,NULL);
+	}
+	for (unsigned int i = 0; i < workers.size(); i++) {
+		pthread_mutex_destroy(&workers[i]->mutex);
+		delete workers[i];
+	}
+	workers.clear();
+	pthread_cond_destroy(&done);
+	pthread_cond_destroy(&work);
+	pthread_mutex_destroy(&mutex);
+}
+
+void Thread_pool::submit(void (*task)(void*),void* arg)
+{
+	Task t = {task,arg};
+	Worker* worker = (Worker*) current_worker;
+	if (worker == NULL || worker->pool != this) {
+		worker = workers[next_worker.fetch_add(1) % workers.size()];
+	}
+	unfinished.fetch_add(1);
+	push(worker,t);
+}
+
+void Thread_pool::push(Worker* worker,const Task& task)
+{
+	pthread_mutex_lock(&worker->mutex);
+	worker->tasks.push_back(task);
+	pthread_mutex_unlock(&worker->mutex);
+
+	queued.fetch_add(1);
+	pthread_mutex_lock(&mutex);
+	pthread_cond_signal(&work);
+	pthread_mutex_unlock(&mutex);
+}
+
+// the newest task on worker's own deque, else the oldest on another's
+bool Thread_pool::take(Worker* worker,Task& task)
+{
+	pthread_mutex_lock(&worker->mutex);
+	bool found = !worker->tasks.empty();
+	if (found) {
+		task = worker->tasks.back();
+		worker->tasks.pop_back();
+	}
+	pthread_mutex_unlock(&worker->mutex);
+
+	// look round the others starting with the next, so thieves spread
+	for (unsigned int i = 1; !found && i < workers.size(); i++) {
+		Worker* victim = workers[(worker->index+i) % workers.size()];
+		pthread_mutex_lock(&victim->mutex);
+		found = !victim->tasks.empty();
+		if (found) {
+			task = victim->tasks.front();
+			victim->tasks.pop_front();
+			worker->steals.add();
+		}
+		pthread_mutex_unlock(&victim->mutex);
+	}
+
+	if (found) {
+		queued.fetch_sub(1);
+	}
+	return found;
+}
+
+void* Thread_pool::loop(void* worker0)
+{
+	Worker* worker = (Worker*) worker0;
+	Thread_pool* pool = worker->pool;
+	current_worker = worker;
+	while (true) {
+		Task task;
+		if (pool->take(worker,task)) {
+			task.task(task.arg);
+			worker->tasks_run.add();
+			if (pool->unfinished.fetch_sub(1) == 1) {
+				pthread_mutex_lock(&pool->mutex);
+				pthread_cond_broadcast(&pool->done);
+				pthread_mutex_unlock(&pool->mutex);
+			}
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->mutex);
+		while (pool->running && pool->queued.load() == 0) {
+			pthread_cond_wait(&pool->work,&pool->mutex);
+		}
+		bool running = pool->running;
+		pthread_mutex_unlock(&pool->mutex);
+		if (!running) {
+			break;
+		}
+	}
+	current_worker = NULL;
+	return NULL;
+}
+
+void Thread_pool::wait()
+{
+	pthread_mutex_lock(&mutex);
+	while (unfinished.load() > 0) {
+		pthread_cond_wait(&done,&mutex);
+	}
+	pthread_mutex_unlock(&mutex);
+}
+
+unsigned int Thread_pool::get_threads() const
+{
+	return workers.size();
+}
+
+unsigned long Thread_pool::get_tasks_run() const
+{
+	unsigned long n = 0;
+	for (unsigned int i = 0; i < workers.size(); i++) {
+		n += workers[i]->tasks_run.get();
+	}
+	return n;
+}
+
+unsigned long Thread_pool::get_steals() const
+{
+	unsigned long n = 0;
+	for (unsigned int i = 0; i < workers.size(); i++) {
+		n += workers[i]->steals.get();
+	}
+	return n;
+}
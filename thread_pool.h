@@ -0,0 +1,86 @@
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <vector>
+#include <pthread.h>
+
+#include "metrics.h"
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+using namespace std;
+
+// Thread_pool_exception --------------------------------------------------
+
+class Thread_pool_exception: public exception {
+};
+
+// Thread_pool ------------------------------------------------------------
+
+// Runs independent tasks on a fixed set of threads. Each thread has a
+// deque of its own: it takes its newest task first, and when the deque is
+// empty it steals the oldest task of another thread, so threads that draw
+// short tasks help out those that draw long ones. The deques have a lock
+// each, held only to push or take a task; meant for tasks of a
+// millisecond or more, like a whole simulation run
+class Thread_pool {
+public:
+	// threads 0 starts one thread per online processor. throw
+	// Thread_pool_exception if a thread cannot be started
+	Thread_pool(unsigned int threads = 0);
+	// waits for every task, then stops the threads
+	~Thread_pool();
+
+	// run task(arg) on some thread. A task's submits go on its own
+	// thread's deque, to run next there unless stolen; others go on the
+	// threads' deques in turn
+	void submit(void (*task)(void*),void* arg);
+
+	// return once every task submitted so far has run, and any they
+	// submitted
+	void wait();
+
+	unsigned int get_threads() const;
+	unsigned long get_tasks_run() const;
+	unsigned long get_steals() const; // tasks run by another thread
+private:
+	Thread_pool(const Thread_pool&);
+	Thread_pool& operator=(const Thread_pool&);
+
+	struct Task {
+		void (*task)(void*);
+		void* arg;
+	};
+
+	struct Worker {
+		Thread_pool* pool;
+		unsigned int index;
+		pthread_t thread;
+		pthread_mutex_t mutex; // guards tasks
+		deque<Task> tasks; // newest at the back
+		Counter tasks_run;
+		Counter steals;
+	};
+
+	static void* loop(void* worker);
+	bool take(Worker* worker,Task& task);
+	void push(Worker* worker,const Task& task);
+	void stop();
+
+	vector<Worker*> workers;
+	std::atomic<unsigned int> next_worker; // for submits from outside
+
+	// queued counts tasks in the deques, unfinished tasks submitted and
+	// not yet run. Both change without mutex; a thread that finds no
+	// task, or a wait, checks them with it held before sleeping, and
+	// whoever changes them takes it before signalling
+	pthread_mutex_t mutex;
+	pthread_cond_t work;
+	pthread_cond_t done;
+	std::atomic<unsigned long> queued;
+	std::atomic<unsigned long> unfinished;
+	bool running; // guarded by mutex
+};
+
+#endif
@@ -79,4 +79,14 @@ inline struct timeval operator-=(struct timeval& t0,struct timeval t1) {
 	return t0;
 }
 
+// ***** conversion *****
+inline struct timeval usec_to_timeval(unsigned long usec) {
+	struct timeval t = {(time_t) (usec/1000000),
+		(suseconds_t) (usec%1000000)};
+	return t;
+}
+inline unsigned long timeval_to_usec(struct timeval t) {
+	return t.tv_sec*1000000ul+t.tv_usec;
+}
+
 #endif
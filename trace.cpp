@@ -0,0 +1,109 @@
+#include <unistd.h>
+
+#include "trace.h"
+
+using namespace std;
+
+// Trace_writer -----------------------------------------------------------
+
+Trace_writer::Trace_writer(const char* path,unsigned int ring_capacity0)
+{
+	file = fopen(path,"wb");
+	if (file == NULL) {
+		throw Trace_exception();
+	}
+	Trace_file_header header;
+	memset(&header,0,sizeof(header));
+	memcpy(header.magic,TRACE_MAGIC,sizeof(TRACE_MAGIC));
+	header.version = TRACE_VERSION;
+	header.record_length = sizeof(Trace_record);
+	if (fwrite(&header,sizeof(header),1,file) != 1) {
+		fclose(file);
+		throw Trace_exception();
+	}
+
+	ring_capacity = ring_capacity0;
+	pthread_mutex_init(&mutex,NULL);
+	running.store(true);
+	if (pthread_create(&thread,NULL,&Trace_writer::loop,this) != 0) {
+		pthread_mutex_destroy(&mutex);
+		fclose(file);
+		throw Trace_exception();
+	}
+}
+
+Trace_writer::~Trace_writer()
+{
+	running.store(false);
+	pthread_join(thread,NULL);
+	drain();
+	fclose(file);
+	for (unsigned int i = 0; i < rings.size(); i++) {
+		delete rings[i];
+	}
+	pthread_mutex_destroy(&mutex);
+}
+
+Trace_ring* Trace_writer::add_ring()
+{
+	Trace_ring* ring = new Trace_ring(ring_capacity);
+	pthread_mutex_lock(&mutex);
+	rings.push_back(ring);
+	pthread_mutex_unlock(&mutex);
+	return ring;
+}
+
+void Trace_writer::flush()
+{
+	drain();
+	pthread_mutex_lock(&mutex);
+	fflush(file);
+	pthread_mutex_unlock(&mutex);
+}
+
+unsigned long Trace_writer::get_records_written()
+{
+	return records_written.get();
+}
+
+unsigned long Trace_writer::get_records_dropped()
+{
+	unsigned long dropped = 0;
+	pthread_mutex_lock(&mutex);
+	for (unsigned int i = 0; i < rings.size(); i++) {
+		dropped += rings[i]->get_dropped();
+	}
+	pthread_mutex_unlock(&mutex);
+	return dropped;
+}
+
+// write out every record in every ring; return how many there were
+unsigned int Trace_writer::drain()
+{
+	unsigned int n = 0;
+	pthread_mutex_lock(&mutex);
+	for (unsigned int i = 0; i < rings.size(); i++) {
+		// straight from the ring, a contiguous run of slots at a time
+		Trace_record* first;
+		unsigned int run;
+		while ((run = rings[i]->ring.front_run(first)) > 0) {
+			fwrite(first,sizeof(Trace_record),run,file);
+			rings[i]->ring.pop(run);
+			n += run;
+		}
+	}
+	records_written.add(n);
+	pthread_mutex_unlock(&mutex);
+	return n;
+}
+
+void* Trace_writer::loop(void* trace_writer)
+{
+	Trace_writer* writer = (Trace_writer*) trace_writer;
+	while (writer->running.load()) {
+		if (writer->drain() == 0) {
+			usleep(DRAIN_PERIOD);
+		}
+	}
+	return NULL;
+}
@@ -0,0 +1,144 @@
+#include <atomic>
+#include <exception>
+#include <vector>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "metrics.h"
+#include "spsc_ring.h"
+
+#ifndef TRACE_H
+#define TRACE_H
+
+using namespace std;
+
+// Trace_exception --------------------------------------------------------
+
+class Trace_exception: public exception {
+};
+
+// Trace_record -----------------------------------------------------------
+
+enum {TRACE_CAPTURE_LENGTH = 32}; // bytes of each frame kept: its header
+
+// event
+enum {TRACE_SEND = 0, TRACE_RECEIVE = 1};
+
+// flags
+enum {TRACE_DROPPED = 1, TRACE_CORRUPTED = 2, TRACE_REORDERED = 4,
+ TRACE_DUPLICATED = 8};
+
+// one frame sent or received by an interface; 48 bytes, written to a
+// trace file as is
+struct Trace_record {
+	unsigned long long time; // microseconds on the physical layer's clock
+	unsigned int length; // of the whole frame
+	unsigned char side; // 'a' or 'b'
+	unsigned char event;
+	unsigned char flags;
+	unsigned char captured; // bytes of the frame in data
+	unsigned char data[TRACE_CAPTURE_LENGTH];
+};
+
+// a trace file: this header, then Trace_records until the end
+struct Trace_file_header {
+	char magic[8]; // TRACE_MAGIC
+	unsigned int version;
+	unsigned int record_length; // sizeof(Trace_record)
+};
+
+#define TRACE_MAGIC "LLTRACE"
+enum {TRACE_VERSION = 1};
+
+// Trace_ring -------------------------------------------------------------
+
+// Records from one interface on their way to a Trace_writer. record is
+// called with the physical layer's buffer lock held, which makes the
+// interface's threads one producer; the writer is the consumer. A full
+// ring drops the record and counts it rather than hold up the channel
+class Trace_ring {
+public:
+	Trace_ring(unsigned int capacity)
+		: ring(capacity)
+	{
+	}
+
+	void record(unsigned long long time,char side,unsigned char event,
+	 unsigned char flags,const unsigned char frame[],unsigned int length)
+	{
+		Trace_record* r = ring.back();
+		if (r == NULL) {
+			dropped.add();
+			return;
+		}
+		r->time = time;
+		r->length = length;
+		r->side = side;
+		r->event = event;
+		r->flags = flags;
+		r->captured = length < TRACE_CAPTURE_LENGTH ? length
+		 : (unsigned int) TRACE_CAPTURE_LENGTH;
+		memcpy(r->data,frame,r->captured);
+		ring.push();
+	}
+
+	// records lost to a full ring
+	unsigned long get_dropped() const
+	{
+		return dropped.get();
+	}
+private:
+	friend class Trace_writer;
+
+	Trace_ring(const Trace_ring&);
+	Trace_ring& operator=(const Trace_ring&);
+
+	Spsc_ring<Trace_record> ring;
+	Counter dropped;
+};
+
+// Trace_writer -----------------------------------------------------------
+
+// Drains Trace_rings to a trace file on a thread of its own, so tracing
+// costs the traced interfaces a copy into a ring and nothing more.
+// Detach every interface (set_trace(NULL)), or destroy it, before
+// destroying the writer
+class Trace_writer {
+public:
+	enum {DEFAULT_RING_CAPACITY = 1 << 16};
+	enum {DRAIN_PERIOD = 1000}; // microseconds between passes when idle
+
+	// throw Trace_exception if path cannot be written
+	Trace_writer(const char* path,
+	 unsigned int ring_capacity = DEFAULT_RING_CAPACITY);
+	~Trace_writer();
+
+	// a ring for one interface to trace into; owned by the writer
+	Trace_ring* add_ring();
+
+	// write everything traced so far to the file
+	void flush();
+
+	unsigned long get_records_written();
+	unsigned long get_records_dropped(); // by every ring
+private:
+	Trace_writer(const Trace_writer&);
+	Trace_writer& operator=(const Trace_writer&);
+
+	static void* loop(void* trace_writer);
+	unsigned int drain();
+
+	FILE* file;
+	unsigned int ring_capacity;
+
+	// guards rings, the file and the rings' consumer side
+	pthread_mutex_t mutex;
+	vector<Trace_ring*> rings;
+	Counter records_written;
+
+	std::atomic<bool> running;
+	pthread_t thread;
+};
+
+#endif
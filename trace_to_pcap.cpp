@@ -0,0 +1,111 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+using namespace std;
+
+// Converts a trace file written by Trace_writer to a pcap file, for
+// Wireshark, tcpdump and the like. Packets are of link type USER0 (147):
+// a 4-byte pseudo-header - side ('a' or 'b'), event (0 send, 1 receive),
+// flags (1 dropped, 2 corrupted, 4 reordered, 8 duplicated) and a zero
+// byte - then the captured bytes of the frame. A frame's original length
+// is its full length plus the pseudo-header.
+
+const unsigned int LINKTYPE_USER0 = 147;
+const unsigned int PSEUDO_HEADER_LENGTH = 4;
+
+struct Pcap_file_header {
+	unsigned int magic;
+	unsigned short version_major;
+	unsigned short version_minor;
+	int thiszone;
+	unsigned int sigfigs;
+	unsigned int snaplen;
+	unsigned int network;
+};
+
+struct Pcap_record_header {
+	unsigned int ts_sec;
+	unsigned int ts_usec;
+	unsigned int incl_len;
+	unsigned int orig_len;
+};
+
+int main(int argc,char* argv[])
+{
+	if (argc != 3) {
+		cout << "Syntax: " << argv[0] << " trace_file pcap_file" << endl;
+		exit(1);
+	}
+	FILE* in = fopen(argv[1],"rb");
+	if (in == NULL) {
+		cerr << "cannot read " << argv[1] << endl;
+		exit(1);
+	}
+	Trace_file_header header;
+	if (fread(&header,sizeof(header),1,in) != 1
+	 || memcmp(header.magic,TRACE_MAGIC,sizeof(TRACE_MAGIC)) != 0
+	 || header.version != TRACE_VERSION
+	 || header.record_length != sizeof(Trace_record)) {
+		cerr << argv[1] << " is not a version " << TRACE_VERSION
+		 << " trace file" << endl;
+		exit(1);
+	}
+	FILE* out = fopen(argv[2],"wb");
+	if (out == NULL) {
+		cerr << "cannot write " << argv[2] << endl;
+		exit(1);
+	}
+
+	Pcap_file_header pcap_header;
+	pcap_header.magic = 0xa1b2c3d4;
+	pcap_header.version_major = 2;
+	pcap_header.version_minor = 4;
+	pcap_header.thiszone = 0;
+	pcap_header.sigfigs = 0;
+	pcap_header.snaplen = PSEUDO_HEADER_LENGTH+TRACE_CAPTURE_LENGTH;
+	pcap_header.network = LINKTYPE_USER0;
+	fwrite(&pcap_header,sizeof(pcap_header),1,out);
+
+	unsigned long records = 0;
+	unsigned long dropped = 0;
+	unsigned long corrupted = 0;
+	unsigned long reordered = 0;
+	unsigned long duplicated = 0;
+	Trace_record r;
+	while (fread(&r,sizeof(r),1,in) == 1) {
+		if (r.captured > TRACE_CAPTURE_LENGTH) {
+			cerr << "bad record " << records << endl;
+			exit(1);
+		}
+		Pcap_record_header record_header;
+		record_header.ts_sec = r.time/1000000;
+		record_header.ts_usec = r.time%1000000;
+		record_header.incl_len = PSEUDO_HEADER_LENGTH+r.captured;
+		record_header.orig_len = PSEUDO_HEADER_LENGTH+r.length;
+		unsigned char pseudo_header[PSEUDO_HEADER_LENGTH] =
+		 {r.side,r.event,r.flags,0};
+		fwrite(&record_header,sizeof(record_header),1,out);
+		fwrite(pseudo_header,PSEUDO_HEADER_LENGTH,1,out);
+		fwrite(r.data,r.captured,1,out);
+
+		records++;
+		dropped += (r.flags & TRACE_DROPPED) != 0;
+		corrupted += (r.flags & TRACE_CORRUPTED) != 0;
+		reordered += (r.flags & TRACE_REORDERED) != 0;
+		duplicated += (r.flags & TRACE_DUPLICATED) != 0;
+	}
+	fclose(in);
+	if (fclose(out) != 0) {
+		cerr << "cannot write " << argv[2] << endl;
+		exit(1);
+	}
+
+	cout << records << " frames, " << dropped << " dropped, " << corrupted
+	 << " corrupted, " << reordered << " reordered, " << duplicated
+	 << " duplicated" << endl;
+	return 0;
+}